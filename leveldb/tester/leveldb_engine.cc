@@ -0,0 +1,165 @@
+#include "leveldb/db.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/write_batch.h"
+
+#include "easylogging/easylogging++.h"
+#include "kv_engine.h"
+
+class LevelDBIterator : public KVIterator {
+public:
+    explicit LevelDBIterator(leveldb::Iterator* it)
+        : it(it)
+    {
+    }
+
+    ~LevelDBIterator()
+    {
+        delete it;
+    }
+
+    void Seek(const char* key, size_t key_length)
+    {
+        it->Seek(leveldb::Slice(key, key_length));
+    }
+
+    bool Valid()
+    {
+        return it->Valid();
+    }
+
+    void Next()
+    {
+        it->Next();
+    }
+
+    const char* Value(size_t* value_length)
+    {
+        leveldb::Slice value = it->value();
+        *value_length = value.size();
+        return value.data();
+    }
+
+private:
+    leveldb::Iterator* it;
+};
+
+class LevelDBEngine : public KVEngine {
+public:
+    LevelDBEngine()
+        : db(nullptr)
+        , filter_policy(nullptr)
+        , statistics(false)
+    {
+    }
+
+    ~LevelDBEngine()
+    {
+        Close();
+    }
+
+    const char* Name()
+    {
+        return "leveldb";
+    }
+
+    bool Open(const struct engine_options_t* opt)
+    {
+        leveldb::Options options;
+        // the LevelDB codebase only has snappy.
+        options.compression = (opt->compression == COMPRESSION_SNAPPY) ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+        options.max_file_size = opt->max_file_size;
+        options.write_buffer_size = opt->write_buffer_size;
+        filter_policy = leveldb::NewBloomFilterPolicy(opt->bloom_bits);
+        options.filter_policy = filter_policy;
+        options.block_size = opt->block_size;
+        options.create_if_missing = true;
+        statistics = opt->statistics;
+
+        LOG(INFO) << "|-----------------[LevelDB]-----------------";
+        LOG(INFO) << "|- [db path:" << opt->db_path << "]";
+        LOG(INFO) << "|- [write_buffer_size:" << opt->write_buffer_size / (1024 * 1024) << "MB]";
+        LOG(INFO) << "|- [max_file_size:" << opt->max_file_size / (1024 * 1024) << "MB]";
+        LOG(INFO) << "|- [block_size:" << opt->block_size << "]";
+        LOG(INFO) << "|- [bloom_bits:" << opt->bloom_bits << "]";
+        LOG(INFO) << "|- [compression:" << compression_name(opt->compression == COMPRESSION_SNAPPY ? COMPRESSION_SNAPPY : COMPRESSION_NONE) << "]";
+        if (opt->compression != COMPRESSION_NONE && opt->compression != COMPRESSION_SNAPPY) {
+            LOG(INFO) << "|- [" << compression_name(opt->compression) << "] is not supported, blocks are not compressed.";
+        }
+        LOG(INFO) << "|-------------------------------------------";
+
+        leveldb::Status status = leveldb::DB::Open(options, opt->db_path, &db);
+        return status.ok() && db != nullptr;
+    }
+
+    void Close()
+    {
+        delete db;
+        db = nullptr;
+        delete filter_policy;
+        filter_policy = nullptr;
+    }
+
+public:
+    bool Put(const char* key, size_t key_length, const char* value, size_t value_length)
+    {
+        return db->Put(leveldb::WriteOptions(), leveldb::Slice(key, key_length), leveldb::Slice(value, value_length)).ok();
+    }
+
+    bool Get(const char* key, size_t key_length, std::string* value)
+    {
+        return db->Get(leveldb::ReadOptions(), leveldb::Slice(key, key_length), value).ok();
+    }
+
+    bool Delete(const char* key, size_t key_length)
+    {
+        return db->Delete(leveldb::WriteOptions(), leveldb::Slice(key, key_length)).ok();
+    }
+
+    size_t Scan(const char* key, size_t key_length, size_t scan_range, std::vector<std::string>* values)
+    {
+        size_t count = 0;
+        leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
+        for (it->Seek(leveldb::Slice(key, key_length)); it->Valid() && count < scan_range; it->Next()) {
+            values->push_back(it->value().ToString());
+            count++;
+        }
+        delete it;
+        return count;
+    }
+
+    KVIterator* NewIterator()
+    {
+        return new LevelDBIterator(db->NewIterator(leveldb::ReadOptions()));
+    }
+
+    bool WriteBatch(const struct kv_write_t* writes, size_t num_writes)
+    {
+        leveldb::WriteBatch batch;
+        for (size_t i = 0; i < num_writes; i++) {
+            if (writes[i].is_delete) {
+                batch.Delete(leveldb::Slice(writes[i].key, writes[i].key_length));
+            } else {
+                batch.Put(leveldb::Slice(writes[i].key, writes[i].key_length), leveldb::Slice(writes[i].value, writes[i].value_length));
+            }
+        }
+        return db->Write(leveldb::WriteOptions(), &batch).ok();
+    }
+
+    bool Stats(std::string* stats)
+    {
+        return db->GetProperty("leveldb.stats", stats);
+    }
+
+    bool Counters(struct engine_stats_t* stats)
+    {
+        std::string text;
+        return statistics && db->GetProperty("leveldb.stats", &text) && parse_leveldb_stats(text, stats);
+    }
+
+private:
+    leveldb::DB* db;
+    const leveldb::FilterPolicy* filter_policy;
+    bool statistics; // engine_options_t::statistics
+};
+
+REGISTER_KV_ENGINE("leveldb", LevelDBEngine)
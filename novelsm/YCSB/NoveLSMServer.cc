@@ -81,6 +81,7 @@ public:
         printf(">>[DBServer::DBServer] DBServer Start!\n");
         search_match = 0;
         scan_match = 0;
+        delete_match = 0;
         output = 0;
         options.compression = kNoCompression;
         options.write_buffer_size = 64 * 1024 * 1024;
@@ -144,7 +145,7 @@ public:
             }
 
             size_t sum_opt = vec_lat_insert.size() + vec_lat_update.size() + vec_lat_search.size() + vec_lat_delete.size() + vec_lat_scan.size();
-            printf(">>[DBServer::addMap] [SUM:%zu][PUT:%zu][UPDATE:%zu][GET:%llu/%zu][DEL:%zu][SCAN:%zu/%llu]\n", sum_opt, vec_lat_insert.size(), vec_lat_update.size(), search_match, vec_lat_search.size(), vec_lat_delete.size(), vec_lat_scan.size(), scan_match);
+            printf(">>[DBServer::addMap] [SUM:%zu][PUT:%zu][UPDATE:%zu][GET:%llu/%zu][DEL:%llu/%zu][SCAN:%zu/%llu]\n", sum_opt, vec_lat_insert.size(), vec_lat_update.size(), search_match, vec_lat_search.size(), delete_match, vec_lat_delete.size(), vec_lat_scan.size(), scan_match);
             printf("  [Latency:%lluns][IOPS:%llu]\n", sum_lat / sum_opt, (uint64_t)1000000000 / (sum_lat / sum_opt));
 
 #if (defined LATENCY_OUTPUT)
@@ -181,6 +182,7 @@ public:
             result_output("SCAN", vec_lat_scan);
             search_match = 0;
             scan_match = 0;
+            delete_match = 0;
             output++;
             vec_lat_insert.clear();
             vec_lat_search.clear();
@@ -343,6 +345,28 @@ public:
 
     ResponseCode::type remove(const std::string& mapName, const std::string& string_key)
     {
+        boost::ptr_map<std::string, DB>::iterator itr;
+        boost::shared_lock<boost::shared_mutex> readLock(mutex_);
+        itr = maps_.find(mapName);
+
+        if (itr == maps_.end()) {
+            printf("[DBServer::Remove] Invaild Mapper!\n");
+            return ResponseCode::MapNotFound;
+        }
+
+        Timer timer;
+        uint64_t latency_ns;
+
+        timer.Start();
+        Status res = itr->second->Delete(WriteOptions(), string_key);
+        timer.Stop();
+        latency_ns = timer.Get();
+        vec_lat_delete.push_back(latency_ns);
+
+        if (!res.ok()) {
+            return ResponseCode::Error;
+        }
+        delete_match++;
         return ResponseCode::Success;
     }
 
@@ -354,6 +378,7 @@ private:
 private:
     uint64_t search_match;
     uint64_t scan_match;
+    uint64_t delete_match;
     std::vector<uint64_t> vec_lat_insert;
     std::vector<uint64_t> vec_lat_update;
     std::vector<uint64_t> vec_lat_search;
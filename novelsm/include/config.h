@@ -1,10 +0,0 @@
-#ifndef INCLUDE_CONFIG_H_
-#define INCLUDE_CONFIG_H_
-
-#define MAX_KEY_LENGTH (16)
-#define MAX_VALUE_LENGTH (66535)
-
-// #define THREAD_BIND_CPU
-// #define DEBUG_PRINT
-
-#endif
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "rocksdb/db.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/statistics.h"
+#include "rocksdb/table.h"
+#include "rocksdb/write_batch.h"
+
+#include "easylogging/easylogging++.h"
+#include "kv_engine.h"
+
+class RocksDBIterator : public KVIterator {
+public:
+    explicit RocksDBIterator(rocksdb::Iterator* it)
+        : it(it)
+    {
+    }
+
+    ~RocksDBIterator()
+    {
+        delete it;
+    }
+
+    void Seek(const char* key, size_t key_length)
+    {
+        it->Seek(rocksdb::Slice(key, key_length));
+    }
+
+    bool Valid()
+    {
+        return it->Valid();
+    }
+
+    void Next()
+    {
+        it->Next();
+    }
+
+    const char* Value(size_t* value_length)
+    {
+        rocksdb::Slice value = it->value();
+        *value_length = value.size();
+        return value.data();
+    }
+
+private:
+    rocksdb::Iterator* it;
+};
+
+class RocksDBEngine : public KVEngine {
+public:
+    RocksDBEngine()
+        : db(nullptr)
+    {
+    }
+
+    ~RocksDBEngine()
+    {
+        Close();
+    }
+
+    const char* Name()
+    {
+        return "rocksdb";
+    }
+
+    bool Open(const struct engine_options_t* opt)
+    {
+        rocksdb::Options options;
+        static const rocksdb::CompressionType compression_type[COMPRESSION_COUNT] = {
+            rocksdb::kNoCompression, rocksdb::kSnappyCompression, rocksdb::kLZ4Compression, rocksdb::kZSTD
+        };
+        options.compression = compression_type[opt->compression];
+        options.write_buffer_size = opt->write_buffer_size;
+        rocksdb::BlockBasedTableOptions table_options;
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(opt->bloom_bits, false));
+        options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+        options.create_if_missing = true;
+        options.target_file_size_base = opt->max_file_size;
+        if (opt->statistics) {
+            statistics = rocksdb::CreateDBStatistics();
+            options.statistics = statistics;
+        }
+
+        LOG(INFO) << "|-----------------[RocksDB]-----------------";
+        LOG(INFO) << "|- [db path:" << opt->db_path << "]";
+        LOG(INFO) << "|- [write_buffer_size:" << opt->write_buffer_size / (1024 * 1024) << "MB]";
+        LOG(INFO) << "|- [max_file_size:" << opt->max_file_size / (1024 * 1024) << "MB]";
+        LOG(INFO) << "|- [block_size:" << opt->block_size << "]";
+        LOG(INFO) << "|- [bloom_bits:" << opt->bloom_bits << "]";
+        LOG(INFO) << "|- [compression:" << compression_name(opt->compression) << "]";
+        LOG(INFO) << "|- [statistics:" << (opt->statistics ? "on" : "off") << "]";
+        LOG(INFO) << "|-------------------------------------------";
+
+        rocksdb::Status status = rocksdb::DB::Open(options, opt->db_path, &db);
+        return status.ok() && db != nullptr;
+    }
+
+    void Close()
+    {
+        delete db;
+        db = nullptr;
+        statistics.reset();
+    }
+
+public:
+    bool Put(const char* key, size_t key_length, const char* value, size_t value_length)
+    {
+        return db->Put(rocksdb::WriteOptions(), rocksdb::Slice(key, key_length), rocksdb::Slice(value, value_length)).ok();
+    }
+
+    bool Get(const char* key, size_t key_length, std::string* value)
+    {
+        return db->Get(rocksdb::ReadOptions(), rocksdb::Slice(key, key_length), value).ok();
+    }
+
+    bool Delete(const char* key, size_t key_length)
+    {
+        return db->Delete(rocksdb::WriteOptions(), rocksdb::Slice(key, key_length)).ok();
+    }
+
+    size_t Scan(const char* key, size_t key_length, size_t scan_range, std::vector<std::string>* values)
+    {
+        size_t count = 0;
+        rocksdb::Iterator* it = db->NewIterator(rocksdb::ReadOptions());
+        for (it->Seek(rocksdb::Slice(key, key_length)); it->Valid() && count < scan_range; it->Next()) {
+            values->push_back(it->value().ToString());
+            count++;
+        }
+        delete it;
+        return count;
+    }
+
+    KVIterator* NewIterator()
+    {
+        return new RocksDBIterator(db->NewIterator(rocksdb::ReadOptions()));
+    }
+
+    bool WriteBatch(const struct kv_write_t* writes, size_t num_writes)
+    {
+        rocksdb::WriteBatch batch;
+        for (size_t i = 0; i < num_writes; i++) {
+            if (writes[i].is_delete) {
+                batch.Delete(rocksdb::Slice(writes[i].key, writes[i].key_length));
+            } else {
+                batch.Put(rocksdb::Slice(writes[i].key, writes[i].key_length), rocksdb::Slice(writes[i].value, writes[i].value_length));
+            }
+        }
+        return db->Write(rocksdb::WriteOptions(), &batch).ok();
+    }
+
+    size_t MultiGet(const char* const* keys, const size_t* key_lengths, size_t num_keys, std::string* values, bool* found)
+    {
+        std::vector<rocksdb::Slice> vec_keys(num_keys);
+        std::vector<rocksdb::PinnableSlice> vec_values(num_keys);
+        std::vector<rocksdb::Status> status(num_keys);
+        for (size_t i = 0; i < num_keys; i++) {
+            vec_keys[i] = rocksdb::Slice(keys[i], key_lengths[i]);
+        }
+        // the array form batches the lookups through the memtables, filters and
+        // block cache instead of running one Get per key like the vector form.
+        db->MultiGet(rocksdb::ReadOptions(), db->DefaultColumnFamily(), num_keys, vec_keys.data(), vec_values.data(), status.data());
+        size_t num_found = 0;
+        for (size_t i = 0; i < num_keys; i++) {
+            found[i] = status[i].ok();
+            if (found[i]) {
+                values[i].assign(vec_values[i].data(), vec_values[i].size());
+                num_found++;
+            }
+        }
+        return num_found;
+    }
+
+    bool Stats(std::string* stats)
+    {
+        return db->GetProperty("rocksdb.stats", stats);
+    }
+
+    bool Counters(struct engine_stats_t* stats)
+    {
+        if (!statistics) {
+            return false;
+        }
+        stats->Set(ENGINE_STAT_COMPACTION_READ, statistics->getTickerCount(rocksdb::COMPACT_READ_BYTES));
+        stats->Set(ENGINE_STAT_COMPACTION_WRITE, statistics->getTickerCount(rocksdb::COMPACT_WRITE_BYTES) + statistics->getTickerCount(rocksdb::FLUSH_WRITE_BYTES));
+        // every flush records its duration once.
+        rocksdb::HistogramData flush_time;
+        statistics->histogramData(rocksdb::FLUSH_TIME, &flush_time);
+        stats->Set(ENGINE_STAT_FLUSH, flush_time.count);
+        stats->Set(ENGINE_STAT_FLUSH_WRITE, statistics->getTickerCount(rocksdb::FLUSH_WRITE_BYTES));
+        stats->Set(ENGINE_STAT_STALL_MICROS, statistics->getTickerCount(rocksdb::STALL_MICROS));
+        stats->Set(ENGINE_STAT_BLOCK_CACHE_HIT, statistics->getTickerCount(rocksdb::BLOCK_CACHE_HIT));
+        stats->Set(ENGINE_STAT_BLOCK_CACHE_MISS, statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS));
+        stats->Set(ENGINE_STAT_BLOOM_USEFUL, statistics->getTickerCount(rocksdb::BLOOM_FILTER_USEFUL));
+        stats->Set(ENGINE_STAT_BLOOM_POSITIVE, statistics->getTickerCount(rocksdb::BLOOM_FILTER_FULL_POSITIVE));
+        stats->Set(ENGINE_STAT_BLOOM_TRUE_POSITIVE, statistics->getTickerCount(rocksdb::BLOOM_FILTER_FULL_TRUE_POSITIVE));
+        return true;
+    }
+
+private:
+    rocksdb::DB* db;
+    std::shared_ptr<rocksdb::Statistics> statistics; // nullptr unless engine_options_t::statistics
+};
+
+REGISTER_KV_ENGINE("rocksdb", RocksDBEngine)
@@ -12,8 +12,9 @@ NVM_BUFFER_SIZE=${11}
 MAX_FILE_SIZE=${12}
 BLOOM_BITS=${13}
 RESULT_SAVE=${14}
+REPORT_INTERVAL_MS=${15:-1000}
 
 ./$EXEC --db=$DB --nvm=$NVM --key_length=16 --value_length=$VALUE_LENGTH \
 --num_warm=$NUM_WARM --num_put=$NUM_PUT --num_get=$NUM_GET --num_scan=$NUM_SCAN --scan_range=$SCAN_RANGE \
 --write_buffer_size=$WRITE_BUFFER_SIZE --nvm_buffer_size=$NVM_BUFFER_SIZE --max_file_size=$MAX_FILE_SIZE \
---bloom_bits=$BLOOM_BITS > $RESULT_SAVE
\ No newline at end of file
+--bloom_bits=$BLOOM_BITS --report_interval_ms=$REPORT_INTERVAL_MS --report_file=$RESULT_SAVE > $RESULT_SAVE
\ No newline at end of file
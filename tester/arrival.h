@@ -0,0 +1,134 @@
+#ifndef INCLUDE_ARRIVAL_H_
+#define INCLUDE_ARRIVAL_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "timer.h"
+#include "xorshift.h"
+
+#define ARRIVAL_CLOSED (0)
+#define ARRIVAL_CONSTANT (1)
+#define ARRIVAL_POISSON (2)
+
+// Longer waits sleep instead of spinning, the last 100us (above the default 50us
+// timer slack of nanosleep) are spun for precision.
+#define ARRIVAL_SPIN_NS (100000)
+
+// Per-thread open-loop scheduler. Requests are due at a fixed rate (constant or
+// Poisson inter-arrival) no matter how long earlier requests took, and Wait()
+// reports how late a request is sent so latency can be taken from its intended
+// send time instead of hiding queueing delay (coordinated omission).
+class Arrival {
+public:
+    Arrival()
+        : mode(ARRIVAL_CLOSED)
+        , interval_ns(0)
+        , next_ns(0)
+        , seed(1)
+    {
+    }
+
+    Arrival(int mode, double ops_per_sec, uint64_t seed_)
+        : mode(ops_per_sec > 0 ? mode : ARRIVAL_CLOSED)
+        , interval_ns(ops_per_sec > 0 ? 1000000000.0 / ops_per_sec : 0)
+        , next_ns(0)
+        , seed(seed_ | 1)
+    {
+    }
+
+    // CLOCK_MONOTONIC ns, read from the calibrated TSC when there is one.
+    static uint64_t Now(void)
+    {
+        return TscClock::Get().Now();
+    }
+
+    static int Parse(const char* name)
+    {
+        if (strcmp(name, "constant") == 0) {
+            return ARRIVAL_CONSTANT;
+        } else if (strcmp(name, "poisson") == 0) {
+            return ARRIVAL_POISSON;
+        }
+        return -1;
+    }
+
+    static const char* Name(int mode)
+    {
+        switch (mode) {
+        case ARRIVAL_CONSTANT:
+            return "constant";
+        case ARRIVAL_POISSON:
+            return "poisson";
+        default:
+            return "closed";
+        }
+    }
+
+    bool OpenLoop(void)
+    {
+        return mode != ARRIVAL_CLOSED;
+    }
+
+    void Start(void)
+    {
+        next_ns = Now();
+    }
+
+    // Returns when the next request is due (Now() clock) without waiting, for
+    // callers that wait on their own, e.g. clients sharing a thread.
+    uint64_t Next(void)
+    {
+        uint64_t due = next_ns;
+        next_ns += NextInterval();
+        return due;
+    }
+
+    // Blocks until the next request is due and returns how late (ns) it is sent.
+    uint64_t Wait(void)
+    {
+        if (mode == ARRIVAL_CLOSED) {
+            return 0;
+        }
+        return WaitUntil(Next());
+    }
+
+    // Blocks until due (Now() clock) and returns how late (ns) it returns.
+    static uint64_t WaitUntil(uint64_t due)
+    {
+        uint64_t now = Now();
+        if (now < due && due - now > ARRIVAL_SPIN_NS) {
+            uint64_t sleep_ns = due - now - ARRIVAL_SPIN_NS;
+            struct timespec ts;
+            ts.tv_sec = sleep_ns / 1000000000;
+            ts.tv_nsec = sleep_ns % 1000000000;
+            nanosleep(&ts, NULL);
+            now = Now();
+        }
+        while (now < due) {
+            now = Now();
+        }
+        return now - due;
+    }
+
+private:
+    uint64_t NextInterval(void)
+    {
+        if (mode == ARRIVAL_POISSON) {
+            // exponential inter-arrival, u in (0, 1]
+            double u = ((xorshift_random(&seed) >> 11) + 1) * (1.0 / 9007199254740992.0);
+            return (uint64_t)(-log(u) * interval_ns);
+        }
+        return (uint64_t)interval_ns;
+    }
+
+private:
+    int mode;
+    double interval_ns;
+    uint64_t next_ns;
+    uint64_t seed;
+};
+
+#endif
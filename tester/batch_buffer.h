@@ -0,0 +1,101 @@
+#ifndef INCLUDE_BATCH_BUFFER_H_
+#define INCLUDE_BATCH_BUFFER_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "kv_engine.h"
+
+// Gathers consecutive puts/deletes of one thread and writes them with a single
+// KVEngine::WriteBatch. Keys and values are copied in, so callers may reuse
+// their buffers right after Add(). The batch is full once it holds batch_size
+// entries or batch_bytes key/value bytes (0 disables either limit).
+class BatchBuffer {
+public:
+    BatchBuffer(size_t batch_size, size_t batch_bytes)
+        : batch_size(batch_size)
+        , batch_bytes(batch_bytes)
+        , num_delete(0)
+    {
+    }
+
+    void Add(bool is_delete, const char* key, size_t key_length, const char* value, size_t value_length)
+    {
+        if (is_delete) {
+            value_length = 0;
+            num_delete++;
+        }
+        entry_t entry;
+        entry.is_delete = is_delete;
+        entry.offset = arena.size();
+        entry.key_length = key_length;
+        entry.value_length = value_length;
+        arena.resize(arena.size() + key_length + value_length);
+        memcpy(&arena[entry.offset], key, key_length);
+        if (value_length > 0) {
+            memcpy(&arena[entry.offset + key_length], value, value_length);
+        }
+        entries.push_back(entry);
+    }
+
+    bool Full(void) const
+    {
+        return (batch_size > 0 && entries.size() >= batch_size) || (batch_bytes > 0 && arena.size() >= batch_bytes);
+    }
+
+    size_t Count(void) const
+    {
+        return entries.size();
+    }
+
+    size_t NumDelete(void) const
+    {
+        return num_delete;
+    }
+
+    // Key and value bytes of the batch.
+    size_t Bytes(void) const
+    {
+        return arena.size();
+    }
+
+    bool Write(KVEngine* db)
+    {
+        // the arena only stops moving once the batch is complete.
+        writes.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            writes[i].is_delete = entries[i].is_delete;
+            writes[i].key = &arena[entries[i].offset];
+            writes[i].key_length = entries[i].key_length;
+            writes[i].value = writes[i].key + entries[i].key_length;
+            writes[i].value_length = entries[i].value_length;
+        }
+        return db->WriteBatch(writes.data(), writes.size());
+    }
+
+    void Clear(void)
+    {
+        entries.clear();
+        arena.clear();
+        num_delete = 0;
+    }
+
+private:
+    struct entry_t {
+        bool is_delete;
+        size_t offset;
+        size_t key_length;
+        size_t value_length;
+    };
+
+    size_t batch_size;
+    size_t batch_bytes;
+    size_t num_delete;
+    std::vector<entry_t> entries;
+    std::vector<char> arena;
+    std::vector<kv_write_t> writes;
+};
+
+#endif
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <atomic>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "histogram.h"
+#include "latency_file.h"
+
+// Analyses the binary latency files (latency_file.h) the drivers write with
+// STORE_EACH_LATENCY. Every file of the directory is mmap'ed, files of the same
+// op type are merged, and a pool of threads makes a single pass over all the
+// samples: each chunk fills the worker's histogram of its op and picks the
+// exact tail of every window of consecutive samples with nth_element. Writes
+//   <dir>/<op>_cdf.csv   latency,fraction of samples at or below it
+//   <dir>/<op>_tail.csv  thread,window,count,p50,p99,p99.9,p99.99,max
+//   <dir>/summary.json   count, average and percentiles of every op
+//
+// usage: detail <dir> [window] [num_thread]
+
+#define DEFAULT_WINDOW (10000)
+// a chunk is this many samples rounded up to whole windows
+#define CHUNK_SAMPLES (1 << 20)
+
+struct input_file_t {
+    std::string path;
+    int thread_id;
+    int op; // index into the op names
+    const uint64_t* samples;
+    uint64_t num_sample;
+    void* map;
+    size_t map_size;
+};
+
+struct window_t {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t p9999;
+    uint64_t max;
+};
+
+// Consecutive whole windows of one file, analysed by one worker.
+struct chunk_t {
+    int file;
+    uint64_t begin;
+    uint64_t end;
+    std::vector<window_t> windows;
+};
+
+static bool open_file(const char* path, input_file_t* file)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(latency_header_t)) {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    const latency_header_t* header = (const latency_header_t*)addr;
+    if (header->magic != LATENCY_MAGIC || header->version != LATENCY_VERSION) {
+        munmap(addr, st.st_size);
+        return false;
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    madvise(addr, st.st_size, MADV_WILLNEED);
+    // a file cut short (the run was killed) still has its complete samples.
+    uint64_t available = (st.st_size - sizeof(latency_header_t)) / sizeof(uint64_t);
+    file->path = path;
+    file->thread_id = header->thread_id;
+    file->samples = (const uint64_t*)((const char*)addr + sizeof(latency_header_t));
+    file->num_sample = std::min(header->num_sample, available);
+    file->map = addr;
+    file->map_size = st.st_size;
+    return true;
+}
+
+// Exact nearest-rank percentiles of a window, scratch is reordered.
+static window_t window_tail(std::vector<uint64_t>& scratch)
+{
+    static const double p[4] = { 0.5, 0.99, 0.999, 0.9999 };
+    uint64_t value[4];
+    size_t n = scratch.size();
+    size_t from = 0;
+    for (int i = 0; i < 4; i++) {
+        size_t rank = (size_t)(p[i] * n + 0.999999);
+        rank = (rank < 1) ? 0 : std::min(rank, n) - 1;
+        // every percentile is at or past the one before, so only the rest is searched.
+        std::nth_element(scratch.begin() + from, scratch.begin() + rank, scratch.end());
+        value[i] = scratch[rank];
+        from = rank;
+    }
+    window_t w;
+    w.count = n;
+    w.p50 = value[0];
+    w.p99 = value[1];
+    w.p999 = value[2];
+    w.p9999 = value[3];
+    w.max = *std::max_element(scratch.begin() + from, scratch.end());
+    return w;
+}
+
+static void analyse_chunks(const std::vector<input_file_t>* files, std::vector<chunk_t>* chunks, std::atomic<size_t>* next,
+    uint64_t window, std::vector<Histogram>* histograms)
+{
+    std::vector<uint64_t> scratch;
+    scratch.reserve(window);
+    size_t c;
+    while ((c = next->fetch_add(1)) < chunks->size()) {
+        chunk_t* chunk = &(*chunks)[c];
+        const input_file_t& file = (*files)[chunk->file];
+        Histogram* histogram = &(*histograms)[file.op];
+        for (uint64_t i = chunk->begin; i < chunk->end; i += window) {
+            uint64_t end = std::min(i + window, chunk->end);
+            scratch.assign(file.samples + i, file.samples + end);
+            for (size_t j = 0; j < scratch.size(); j++) {
+                histogram->Add(scratch[j]);
+            }
+            chunk->windows.push_back(window_tail(scratch));
+        }
+    }
+}
+
+static void write_cdf(const char* name, const Histogram& histogram)
+{
+    FILE* fout = fopen(name, "w");
+    if (fout == nullptr) {
+        return;
+    }
+    fprintf(fout, "latency,fraction\n");
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_NUM_BUCKET; i++) {
+        if (histogram.BucketCount(i) > 0) {
+            seen += histogram.BucketCount(i);
+            uint64_t value = std::min(Histogram::BucketValue(i), histogram.Max());
+            fprintf(fout, "%llu,%.9f\n", (unsigned long long)value, 1.0 * seen / histogram.Count());
+        }
+    }
+    fclose(fout);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        printf("usage: %s <dir> [window] [num_thread]\n", argv[0]);
+        return -1;
+    }
+    const char* dir = argv[1];
+    uint64_t window = (argc > 2) ? strtoull(argv[2], nullptr, 10) : DEFAULT_WINDOW;
+    int num_thread = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    window = (window == 0) ? DEFAULT_WINDOW : window;
+    num_thread = (num_thread <= 0) ? 1 : num_thread;
+
+    DIR* dirp = opendir(dir);
+    if (dirp == nullptr) {
+        printf("can not open (%s)\n", dir);
+        return -1;
+    }
+    std::vector<std::string> op_names;
+    std::map<std::string, int> op_index;
+    std::vector<input_file_t> files;
+    struct dirent* dp;
+    while ((dp = readdir(dirp)) != nullptr) {
+        const char* dot = strrchr(dp->d_name, '.');
+        if (dot == nullptr || strcmp(dot + 1, LATENCY_EXTENSION) != 0) {
+            continue;
+        }
+        std::string path = std::string(dir) + "/" + dp->d_name;
+        input_file_t file;
+        if (!open_file(path.c_str(), &file)) {
+            printf(">>[Handler] Skipping [%s], not a latency file.\n", path.c_str());
+            continue;
+        }
+        const latency_header_t* header = (const latency_header_t*)file.map;
+        std::string op(header->op_name, strnlen(header->op_name, LATENCY_OP_NAME_LENGTH));
+        if (op_index.find(op) == op_index.end()) {
+            op_index[op] = op_names.size();
+            op_names.push_back(op);
+        }
+        file.op = op_index[op];
+        files.push_back(file);
+    }
+    closedir(dirp);
+    // windows come out grouped by op and thread.
+    std::sort(files.begin(), files.end(), [&](const input_file_t& a, const input_file_t& b) {
+        return (op_names[a.op] != op_names[b.op]) ? op_names[a.op] < op_names[b.op] : a.thread_id < b.thread_id;
+    });
+
+    uint64_t chunk_samples = (CHUNK_SAMPLES + window - 1) / window * window;
+    std::vector<chunk_t> chunks;
+    uint64_t total = 0;
+    for (size_t f = 0; f < files.size(); f++) {
+        for (uint64_t begin = 0; begin < files[f].num_sample; begin += chunk_samples) {
+            chunk_t chunk;
+            chunk.file = f;
+            chunk.begin = begin;
+            chunk.end = std::min(begin + chunk_samples, files[f].num_sample);
+            chunks.push_back(chunk);
+        }
+        total += files[f].num_sample;
+    }
+    printf(">>[Handler] Reading operator latency from [%s] (%zu files, %llu samples, %d threads).\n", dir, files.size(),
+        (unsigned long long)total, num_thread);
+
+    // one histogram per op for every worker, merged once all are done.
+    std::vector<std::vector<Histogram>> histograms(num_thread, std::vector<Histogram>(op_names.size()));
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_thread; i++) {
+        workers.push_back(std::thread(analyse_chunks, &files, &chunks, &next, window, &histograms[i]));
+    }
+    for (int i = 0; i < num_thread; i++) {
+        workers[i].join();
+    }
+
+    char name[512];
+    snprintf(name, sizeof(name), "%s/summary.json", dir);
+    FILE* summary = fopen(name, "w");
+    if (summary != nullptr) {
+        fprintf(summary, "{\n  \"window\": %llu,\n  \"ops\": {", (unsigned long long)window);
+    }
+    for (size_t op = 0; op < op_names.size(); op++) {
+        const char* op_name = op_names[op].c_str();
+        Histogram merged;
+        for (int i = 0; i < num_thread; i++) {
+            merged.Merge(histograms[i][op]);
+        }
+        snprintf(name, sizeof(name), "%s/%s_cdf.csv", dir, op_name);
+        write_cdf(name, merged);
+
+        snprintf(name, sizeof(name), "%s/%s_tail.csv", dir, op_name);
+        FILE* tail = fopen(name, "w");
+        size_t num_window = 0;
+        int num_file = 0;
+        if (tail != nullptr) {
+            fprintf(tail, "thread,window,count,p50,p99,p99.9,p99.99,max\n");
+        }
+        for (size_t c = 0, w = 0; c < chunks.size(); c++) {
+            const input_file_t& file = files[chunks[c].file];
+            if (file.op != (int)op) {
+                continue;
+            }
+            if (chunks[c].begin == 0) {
+                num_file++;
+                w = 0;
+            }
+            for (size_t i = 0; i < chunks[c].windows.size(); i++, w++) {
+                const window_t& t = chunks[c].windows[i];
+                if (tail != nullptr) {
+                    fprintf(tail, "%d,%zu,%llu,%llu,%llu,%llu,%llu,%llu\n", file.thread_id, w, (unsigned long long)t.count,
+                        (unsigned long long)t.p50, (unsigned long long)t.p99, (unsigned long long)t.p999,
+                        (unsigned long long)t.p9999, (unsigned long long)t.max);
+                }
+                num_window++;
+            }
+        }
+        if (tail != nullptr) {
+            fclose(tail);
+        }
+
+        printf("  [%s] (%llu samples, %d files, %zu windows)\n", op_name, (unsigned long long)merged.Count(), num_file, num_window);
+        printf("  [Average]:%9lluns\n", (unsigned long long)merged.Average());
+        static const double p[6] = { 0.5, 0.75, 0.90, 0.99, 0.999, 0.9999 };
+        for (int i = 0; i < 6; i++) {
+            printf("  [%.2fth]:%9lluns\n", 100.0 * p[i], (unsigned long long)merged.Percentile(p[i]));
+        }
+        if (summary != nullptr) {
+            fprintf(summary, "%s\n    \"%s\": { \"files\": %d, \"count\": %llu, \"avg\": %llu, \"min\": %llu, \"max\": %llu, "
+                             "\"p50\": %llu, \"p75\": %llu, \"p90\": %llu, \"p99\": %llu, \"p99.9\": %llu, \"p99.99\": %llu }",
+                (op == 0) ? "" : ",", op_name, num_file, (unsigned long long)merged.Count(), (unsigned long long)merged.Average(),
+                (unsigned long long)merged.Min(), (unsigned long long)merged.Max(), (unsigned long long)merged.Percentile(0.5),
+                (unsigned long long)merged.Percentile(0.75), (unsigned long long)merged.Percentile(0.9),
+                (unsigned long long)merged.Percentile(0.99), (unsigned long long)merged.Percentile(0.999),
+                (unsigned long long)merged.Percentile(0.9999));
+        }
+    }
+    if (summary != nullptr) {
+        fprintf(summary, "\n  }\n}\n");
+        fclose(summary);
+    }
+
+    for (size_t f = 0; f < files.size(); f++) {
+        munmap(files[f].map, files[f].map_size);
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+#ifndef INCLUDE_ENGINE_STATS_H_
+#define INCLUDE_ENGINE_STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+// Engine-internal counters, cumulative since the engine was opened. An
+// adapter fills what its engine keeps (KVEngine::Counters), the tester diffs
+// two snapshots to get what one phase did.
+#define ENGINE_STAT_COMPACTION_READ (0) // bytes read by compactions
+#define ENGINE_STAT_COMPACTION_WRITE (1) // table bytes written by compactions and memtable flushes
+#define ENGINE_STAT_FLUSH (2) // memtable flushes
+#define ENGINE_STAT_FLUSH_WRITE (3) // table bytes written by memtable flushes
+#define ENGINE_STAT_STALL_MICROS (4) // time writes were slowed down or stopped
+#define ENGINE_STAT_BLOCK_CACHE_HIT (5)
+#define ENGINE_STAT_BLOCK_CACHE_MISS (6)
+#define ENGINE_STAT_BLOOM_USEFUL (7) // lookups a filter ruled out
+#define ENGINE_STAT_BLOOM_POSITIVE (8) // lookups a filter let through
+#define ENGINE_STAT_BLOOM_TRUE_POSITIVE (9) // the ones of those that found the key
+#define ENGINE_STAT_COUNT (10)
+
+struct engine_stats_t {
+public:
+    uint64_t value[ENGINE_STAT_COUNT];
+    bool has[ENGINE_STAT_COUNT]; // the engine reports the counter
+
+public:
+    engine_stats_t()
+    {
+        memset(value, 0, sizeof(value));
+        memset(has, 0, sizeof(has));
+    }
+
+    void Set(int stat, uint64_t v)
+    {
+        value[stat] = v;
+        has[stat] = true;
+    }
+
+    // What happened between two snapshots, for the counters both of them have.
+    static engine_stats_t Diff(const engine_stats_t& before, const engine_stats_t& after)
+    {
+        engine_stats_t diff;
+        for (int i = 0; i < ENGINE_STAT_COUNT; i++) {
+            if (before.has[i] && after.has[i]) {
+                diff.Set(i, (after.value[i] >= before.value[i]) ? after.value[i] - before.value[i] : 0);
+            }
+        }
+        return diff;
+    }
+
+    bool Empty(void) const
+    {
+        for (int i = 0; i < ENGINE_STAT_COUNT; i++) {
+            if (has[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Only what the engine reports, e.g.
+    // [Compaction:12.0MB/30.5MB][Flush:3/12.1MB][Stall:0ms][BlockCache:87.50% of 4096][Bloom:useful 900/fp 12]
+    std::string ToString(void) const
+    {
+        std::string s;
+        char buf[128];
+        if (has[ENGINE_STAT_COMPACTION_READ] || has[ENGINE_STAT_COMPACTION_WRITE]) {
+            snprintf(buf, sizeof(buf), "[Compaction:%.1fMB/%.1fMB]", value[ENGINE_STAT_COMPACTION_READ] / 1048576.0,
+                value[ENGINE_STAT_COMPACTION_WRITE] / 1048576.0);
+            s += buf;
+        }
+        if (has[ENGINE_STAT_FLUSH]) {
+            snprintf(buf, sizeof(buf), "[Flush:%llu/%.1fMB]", (unsigned long long)value[ENGINE_STAT_FLUSH], value[ENGINE_STAT_FLUSH_WRITE] / 1048576.0);
+            s += buf;
+        }
+        if (has[ENGINE_STAT_STALL_MICROS]) {
+            snprintf(buf, sizeof(buf), "[Stall:%llums]", (unsigned long long)value[ENGINE_STAT_STALL_MICROS] / 1000);
+            s += buf;
+        }
+        if (has[ENGINE_STAT_BLOCK_CACHE_HIT] && has[ENGINE_STAT_BLOCK_CACHE_MISS]) {
+            uint64_t lookups = value[ENGINE_STAT_BLOCK_CACHE_HIT] + value[ENGINE_STAT_BLOCK_CACHE_MISS];
+            snprintf(buf, sizeof(buf), "[BlockCache:%.2f%% of %llu]", (lookups == 0) ? 0.0 : 100.0 * value[ENGINE_STAT_BLOCK_CACHE_HIT] / lookups,
+                (unsigned long long)lookups);
+            s += buf;
+        }
+        if (has[ENGINE_STAT_BLOOM_USEFUL]) {
+            snprintf(buf, sizeof(buf), "[Bloom:useful %llu", (unsigned long long)value[ENGINE_STAT_BLOOM_USEFUL]);
+            s += buf;
+            if (has[ENGINE_STAT_BLOOM_POSITIVE] && has[ENGINE_STAT_BLOOM_TRUE_POSITIVE]) {
+                uint64_t positive = value[ENGINE_STAT_BLOOM_POSITIVE];
+                uint64_t false_positive = positive - std::min(positive, value[ENGINE_STAT_BLOOM_TRUE_POSITIVE]);
+                snprintf(buf, sizeof(buf), "/fp %llu", (unsigned long long)false_positive);
+                s += buf;
+            }
+            s += "]";
+        }
+        return s;
+    }
+};
+
+// Sums the compaction table of "leveldb.stats", the LevelDB family keeps no
+// other counters. Read and write are whole MB per level there, and memtable
+// flushes are charged to the level they were written to, so flushes are not
+// told apart. A freshly opened DB has no rows yet, that counts as zero so the
+// first phase still has a snapshot to diff against.
+static inline bool parse_leveldb_stats(const std::string& text, engine_stats_t* stats)
+{
+    double read_mb = 0;
+    double write_mb = 0;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        end = (end == std::string::npos) ? text.size() : end;
+        std::string line = text.substr(begin, end - begin);
+        begin = end + 1;
+        // Level Files Size(MB) Time(sec) Read(MB) Write(MB)
+        int level, files;
+        double size_mb, seconds, read, write;
+        if (sscanf(line.c_str(), "%d %d %lf %lf %lf %lf", &level, &files, &size_mb, &seconds, &read, &write) == 6) {
+            read_mb += read;
+            write_mb += write;
+        }
+    }
+    stats->Set(ENGINE_STAT_COMPACTION_READ, (uint64_t)(read_mb * 1048576));
+    stats->Set(ENGINE_STAT_COMPACTION_WRITE, (uint64_t)(write_mb * 1048576));
+    return true;
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef INCLUDE_HISTOGRAM_H_
+#define INCLUDE_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+// 2^(HISTOGRAM_SUB_BITS - 1) linear sub-buckets per power of two, every recorded
+// value is off by less than 1 / 2^(HISTOGRAM_SUB_BITS - 1) (0.78%).
+#define HISTOGRAM_SUB_BITS (8)
+// Values are clamped below 2^HISTOGRAM_MAX_BITS ns (about 78 hours).
+#define HISTOGRAM_MAX_BITS (48)
+#define HISTOGRAM_NUM_BUCKET (((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) << (HISTOGRAM_SUB_BITS - 1)) + (1 << (HISTOGRAM_SUB_BITS - 1)))
+
+// Fixed-memory, log-bucketed (HDR-style) latency histogram. One instance is only
+// written by its owner thread, instances are combined with Merge() afterwards.
+// Counters are stored with relaxed atomics so another thread can Snapshot() a
+// histogram that is still being written without locking the owner.
+class Histogram {
+public:
+    Histogram()
+    {
+        Clear();
+    }
+
+    void Clear(void)
+    {
+        memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        sum = 0;
+        min = UINT64_MAX;
+        max = 0;
+    }
+
+    void Add(uint64_t value)
+    {
+        int index = BucketIndex(value);
+        __atomic_store_n(&buckets[index], buckets[index] + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&count, count + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&sum, sum + value, __ATOMIC_RELAXED);
+        if (value < min) {
+            __atomic_store_n(&min, value, __ATOMIC_RELAXED);
+        }
+        if (value > max) {
+            __atomic_store_n(&max, value, __ATOMIC_RELAXED);
+        }
+    }
+
+    void Merge(const Histogram& other)
+    {
+        for (int i = 0; i < HISTOGRAM_NUM_BUCKET; i++) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        if (other.min < min) {
+            min = other.min;
+        }
+        if (other.max > max) {
+            max = other.max;
+        }
+    }
+
+    // Copies a histogram that its owner may still be adding to.
+    void Snapshot(Histogram* out) const
+    {
+        for (int i = 0; i < HISTOGRAM_NUM_BUCKET; i++) {
+            out->buckets[i] = __atomic_load_n(&buckets[i], __ATOMIC_RELAXED);
+        }
+        out->count = __atomic_load_n(&count, __ATOMIC_RELAXED);
+        out->sum = __atomic_load_n(&sum, __ATOMIC_RELAXED);
+        out->min = __atomic_load_n(&min, __ATOMIC_RELAXED);
+        out->max = __atomic_load_n(&max, __ATOMIC_RELAXED);
+    }
+
+    // Removes an earlier snapshot of the same histogram, leaving only the values
+    // added in between (min and max stay cumulative).
+    void Subtract(const Histogram& earlier)
+    {
+        for (int i = 0; i < HISTOGRAM_NUM_BUCKET; i++) {
+            buckets[i] -= earlier.buckets[i];
+        }
+        count -= earlier.count;
+        sum -= earlier.sum;
+    }
+
+    uint64_t Count(void) const
+    {
+        return count;
+    }
+
+    // Count() of a histogram that its owner may still be adding to.
+    uint64_t LoadCount(void) const
+    {
+        return __atomic_load_n(&count, __ATOMIC_RELAXED);
+    }
+
+    uint64_t Min(void) const
+    {
+        return (count == 0) ? 0 : min;
+    }
+
+    uint64_t Max(void) const
+    {
+        return max;
+    }
+
+    uint64_t Average(void) const
+    {
+        return (count == 0) ? 0 : sum / count;
+    }
+
+    // p in [0, 1], returns the highest value equivalent to the sample at that rank.
+    uint64_t Percentile(double p) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(p * count + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        if (rank > count) {
+            rank = count;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < HISTOGRAM_NUM_BUCKET; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t value = BucketUpper(i);
+                return (value > max) ? max : value;
+            }
+        }
+        return max;
+    }
+
+    // Samples in bucket index (< HISTOGRAM_NUM_BUCKET) and the highest value it
+    // holds, for walking the whole distribution.
+    uint64_t BucketCount(int index) const
+    {
+        return buckets[index];
+    }
+
+    static uint64_t BucketValue(int index)
+    {
+        return BucketUpper(index);
+    }
+
+    std::string ToString(void) const
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "[Count:%llu][Avg:%lluns][P50:%lluns][P99:%lluns][P99.9:%lluns][P99.99:%lluns][Max:%lluns]",
+            (unsigned long long)count, (unsigned long long)Average(), (unsigned long long)Percentile(0.5),
+            (unsigned long long)Percentile(0.99), (unsigned long long)Percentile(0.999),
+            (unsigned long long)Percentile(0.9999), (unsigned long long)max);
+        return std::string(buf);
+    }
+
+private:
+    static int BucketIndex(uint64_t value)
+    {
+        const uint64_t limit = ((uint64_t)1 << HISTOGRAM_MAX_BITS) - 1;
+        if (value > limit) {
+            value = limit;
+        }
+        if (value < ((uint64_t)1 << HISTOGRAM_SUB_BITS)) {
+            return (int)value;
+        }
+        int shift = (63 - __builtin_clzll(value)) - (HISTOGRAM_SUB_BITS - 1);
+        return (shift << (HISTOGRAM_SUB_BITS - 1)) + (int)(value >> shift);
+    }
+
+    static uint64_t BucketUpper(int index)
+    {
+        if (index < (1 << HISTOGRAM_SUB_BITS)) {
+            return index;
+        }
+        int shift = (index >> (HISTOGRAM_SUB_BITS - 1)) - 1;
+        uint64_t mantissa = index - ((uint64_t)shift << (HISTOGRAM_SUB_BITS - 1));
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    uint64_t buckets[HISTOGRAM_NUM_BUCKET];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+};
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef INCLUDE_IO_STATS_H_
+#define INCLUDE_IO_STATS_H_
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Block layer sectors in /sys/.../stat are always 512 bytes.
+#define IO_SECTOR_SIZE (512)
+
+// What the benchmark asked of the engine during a phase.
+struct io_user_t {
+public:
+    uint64_t puts; // that succeeded
+    uint64_t put_bytes; // their key and value bytes
+    uint64_t deletes; // that succeeded
+    uint64_t delete_bytes; // their key bytes
+    uint64_t gets; // lookups, every key of a MultiGet counts
+
+public:
+    io_user_t()
+        : puts(0)
+        , put_bytes(0)
+        , deletes(0)
+        , delete_bytes(0)
+        , gets(0)
+    {
+    }
+
+    void Add(const io_user_t& other)
+    {
+        puts += other.puts;
+        put_bytes += other.put_bytes;
+        deletes += other.deletes;
+        delete_bytes += other.delete_bytes;
+        gets += other.gets;
+    }
+};
+
+// Cumulative I/O of the process and of the devices under --db/--nvm, and the
+// space the engine's files take at the time of the snapshot.
+struct io_counters_t {
+public:
+    uint64_t read_bytes; // /proc/self/io, fetched from storage by this process
+    uint64_t write_bytes; // /proc/self/io, sent to storage (minus cancelled writeback)
+    uint64_t device_read; // all I/O of the devices, other processes included
+    uint64_t device_write;
+    uint64_t db_space; // allocated bytes of the files under the db path
+    uint64_t nvm_space; // and under the nvm path, 0 if it is the db path
+
+public:
+    io_counters_t()
+        : read_bytes(0)
+        , write_bytes(0)
+        , device_read(0)
+        , device_write(0)
+        , db_space(0)
+        , nvm_space(0)
+    {
+    }
+};
+
+// Turns snapshots into amplification figures. Write amplification is bytes
+// that reached storage over the key and value bytes the phase wrote, read
+// amplification is bytes read from storage per get, and space amplification
+// is what the engine's files take over the live data written so far (new
+// puts add their bytes, deletes take an average record away, overwrites
+// change nothing). Writes to a DAX mapped nvm path bypass the block layer,
+// only its space shows up.
+class IoAccountant {
+public:
+    IoAccountant()
+        : enabled(false)
+        , proc_io(false)
+        , live_records(0)
+        , live_bytes(0)
+    {
+    }
+
+    // Call once the engine has created its files, an accountant that is not
+    // initialised does nothing.
+    void Init(const char* db_path, const char* nvm_path)
+    {
+        enabled = true;
+        this->db_path = db_path;
+        this->nvm_path = (nvm_path != nullptr && strcmp(nvm_path, db_path) != 0) ? nvm_path : "";
+        io_counters_t c;
+        proc_io = ReadProcIo(&c);
+        devices.clear();
+        AddDeviceOf(this->db_path);
+        if (!this->nvm_path.empty()) {
+            AddDeviceOf(this->nvm_path);
+        }
+        Snapshot(&opened);
+    }
+
+    bool Enabled(void) const
+    {
+        return enabled;
+    }
+
+    // Brackets a phase, End() returns its figures.
+    void Begin(void)
+    {
+        if (enabled) {
+            Snapshot(&begin);
+        }
+    }
+
+    std::string End(const io_user_t& user, bool overwrite)
+    {
+        if (!enabled) {
+            return "";
+        }
+        io_counters_t end;
+        Snapshot(&end);
+        AddLive(user, overwrite);
+        total.Add(user);
+        return Report(begin, end, user);
+    }
+
+    // Everything since Init().
+    std::string Total(void) const
+    {
+        if (!enabled) {
+            return "";
+        }
+        io_counters_t now;
+        Snapshot(&now);
+        return Report(opened, now, total);
+    }
+
+    // "[PROC_IO:yes][DEVICE:sda1,pmem0]"
+    std::string ToString(void) const
+    {
+        std::string s = std::string("[PROC_IO:") + (proc_io ? "yes" : "no") + "][DEVICE:";
+        for (size_t i = 0; i < devices.size(); i++) {
+            s += (i > 0 ? "," : "") + devices[i].name;
+        }
+        return s + (devices.empty() ? "none]" : "]");
+    }
+
+    // Writes the dirty pages of the db (and nvm) filesystem back first, so
+    // the I/O a phase caused is charged to it and not to the next one.
+    void Snapshot(io_counters_t* c) const
+    {
+        SyncPath(db_path);
+        if (!nvm_path.empty()) {
+            SyncPath(nvm_path);
+        }
+        ReadProcIo(c);
+        c->device_read = c->device_write = 0;
+        for (size_t i = 0; i < devices.size(); i++) {
+            uint64_t read, write;
+            if (ReadDeviceStat(devices[i].stat_path.c_str(), &read, &write)) {
+                c->device_read += read;
+                c->device_write += write;
+            }
+        }
+        c->db_space = PathSpace(db_path);
+        c->nvm_space = nvm_path.empty() ? 0 : PathSpace(nvm_path);
+    }
+
+private:
+    // Adds a phase's writes to the live data, overwrite when its puts only
+    // rewrote keys that were already there.
+    void AddLive(const io_user_t& user, bool overwrite)
+    {
+        if (!overwrite) {
+            live_records += user.puts;
+            live_bytes += user.put_bytes;
+        }
+        uint64_t deleted = (live_records == 0) ? 0 : std::min(user.deletes, live_records);
+        live_bytes -= (live_records == 0) ? 0 : live_bytes / live_records * deleted;
+        live_records -= deleted;
+    }
+
+    // One line of figures for what happened between two snapshots.
+    std::string Report(const io_counters_t& before, const io_counters_t& after, const io_user_t& user) const
+    {
+        char buf[512];
+        uint64_t user_write = user.put_bytes + user.delete_bytes;
+        uint64_t write = after.write_bytes - before.write_bytes;
+        uint64_t read = after.read_bytes - before.read_bytes;
+        uint64_t device_write = after.device_write - before.device_write;
+        uint64_t device_read = after.device_read - before.device_read;
+        uint64_t space = after.db_space + after.nvm_space;
+        std::string s;
+        snprintf(buf, sizeof(buf), "[UserWrite:%.1fMB]", user_write / 1048576.0);
+        s += buf;
+        if (proc_io) {
+            snprintf(buf, sizeof(buf), "[Write:%.1fMB][Read:%.1fMB]", write / 1048576.0, read / 1048576.0);
+            s += buf;
+        }
+        if (!devices.empty()) {
+            snprintf(buf, sizeof(buf), "[DeviceWrite:%.1fMB][DeviceRead:%.1fMB]", device_write / 1048576.0, device_read / 1048576.0);
+            s += buf;
+        }
+        if (user_write > 0 && proc_io) {
+            snprintf(buf, sizeof(buf), "[WA:%.2f]", 1.0 * write / user_write);
+            s += buf;
+        }
+        if (user_write > 0 && !devices.empty()) {
+            snprintf(buf, sizeof(buf), "[DeviceWA:%.2f]", 1.0 * device_write / user_write);
+            s += buf;
+        }
+        if (user.gets > 0 && proc_io) {
+            snprintf(buf, sizeof(buf), "[Read/Get:%.0fB]", 1.0 * read / user.gets);
+            s += buf;
+        }
+        if (user.gets > 0 && !devices.empty()) {
+            snprintf(buf, sizeof(buf), "[DeviceRead/Get:%.0fB]", 1.0 * device_read / user.gets);
+            s += buf;
+        }
+        snprintf(buf, sizeof(buf), "[Space:%.1fMB", space / 1048576.0);
+        s += buf;
+        if (after.nvm_space > 0) {
+            snprintf(buf, sizeof(buf), "(db %.1fMB+nvm %.1fMB)", after.db_space / 1048576.0, after.nvm_space / 1048576.0);
+            s += buf;
+        }
+        snprintf(buf, sizeof(buf), "][Live:%.1fMB][SA:%.2f]", live_bytes / 1048576.0, (live_bytes == 0) ? 0.0 : 1.0 * space / live_bytes);
+        s += buf;
+        return s;
+    }
+
+public:
+    // Allocated bytes of a file, or of every file below a directory.
+    static uint64_t PathSpace(const std::string& path)
+    {
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0) {
+            return 0;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            return S_ISREG(st.st_mode) ? (uint64_t)st.st_blocks * 512 : 0;
+        }
+        DIR* dir = opendir(path.c_str());
+        if (dir == nullptr) {
+            return 0;
+        }
+        uint64_t space = 0;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                space += PathSpace(path + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+        return space;
+    }
+
+private:
+    struct device_t {
+        dev_t dev;
+        std::string name;
+        std::string stat_path;
+    };
+
+    static bool ReadProcIo(io_counters_t* c)
+    {
+        FILE* fin = fopen("/proc/self/io", "r");
+        if (fin == nullptr) {
+            return false;
+        }
+        char line[128];
+        unsigned long long v;
+        uint64_t cancelled = 0;
+        int found = 0;
+        while (fgets(line, sizeof(line), fin) != nullptr) {
+            if (sscanf(line, "read_bytes: %llu", &v) == 1) {
+                c->read_bytes = v;
+                found++;
+            } else if (sscanf(line, "write_bytes: %llu", &v) == 1) {
+                c->write_bytes = v;
+                found++;
+            } else if (sscanf(line, "cancelled_write_bytes: %llu", &v) == 1) {
+                cancelled = v;
+            }
+        }
+        fclose(fin);
+        c->write_bytes -= std::min(c->write_bytes, cancelled);
+        return found == 2;
+    }
+
+    static bool ReadDeviceStat(const char* stat_path, uint64_t* read, uint64_t* write)
+    {
+        FILE* fin = fopen(stat_path, "r");
+        if (fin == nullptr) {
+            return false;
+        }
+        // reads, merged, sectors, ms, writes, merged, sectors, ...
+        unsigned long long f[7];
+        int n = fscanf(fin, "%llu %llu %llu %llu %llu %llu %llu", &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6]);
+        fclose(fin);
+        if (n != 7) {
+            return false;
+        }
+        *read = f[2] * IO_SECTOR_SIZE;
+        *write = f[6] * IO_SECTOR_SIZE;
+        return true;
+    }
+
+    // The block device (or partition) the path lives on, /sys/dev/block/M:m
+    // links to its /sys/block entry. Filesystems without one (tmpfs, overlay)
+    // are skipped.
+    void AddDeviceOf(const std::string& path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            std::string parent = path.substr(0, path.find_last_of('/'));
+            if (parent == path || stat(parent.empty() ? "/" : parent.c_str(), &st) != 0) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < devices.size(); i++) {
+            if (devices[i].dev == st.st_dev) {
+                return;
+            }
+        }
+        char link[64];
+        snprintf(link, sizeof(link), "/sys/dev/block/%u:%u", major(st.st_dev), minor(st.st_dev));
+        char target[PATH_MAX];
+        ssize_t n = readlink(link, target, sizeof(target) - 1);
+        if (n <= 0) {
+            return;
+        }
+        target[n] = '\0';
+        device_t device;
+        device.dev = st.st_dev;
+        device.name = strrchr(target, '/') ? strrchr(target, '/') + 1 : target;
+        device.stat_path = std::string(link) + "/stat";
+        if (access(device.stat_path.c_str(), R_OK) == 0) {
+            devices.push_back(device);
+        }
+    }
+
+    static void SyncPath(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            syncfs(fd);
+            close(fd);
+        }
+    }
+
+private:
+    bool enabled;
+    std::string db_path;
+    std::string nvm_path; // empty if there is none besides db_path
+    std::vector<device_t> devices;
+    bool proc_io;
+    uint64_t live_records;
+    uint64_t live_bytes;
+    io_counters_t opened; // at Init()
+    io_counters_t begin; // at the last Begin()
+    io_user_t total;
+};
+
+#endif
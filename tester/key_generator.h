@@ -0,0 +1,173 @@
+#ifndef INCLUDE_KEY_GENERATOR_H_
+#define INCLUDE_KEY_GENERATOR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "config.h"
+#include "random.h"
+
+// Keys are the zero-padded decimal form of their seed ("%016llu").
+#define KEY_DIGITS (16)
+#define KEY_STRIDE (((MAX_KEY_LENGTH) + 7) & ~7)
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+#if (MAX_KEY_LENGTH < KEY_DIGITS)
+#error "MAX_KEY_LENGTH must hold KEY_DIGITS digits"
+#endif
+
+// #define GET_FILTER(seed) ((seed % 3 == 0 || seed % 5 == 0 || seed % 7 == 0))
+#define GET_FILTER(seed) ((seed % 1 == 0))
+
+static const char key_digit_pairs[201] = "00010203040506070809"
+                                         "10111213141516171819"
+                                         "20212223242526272829"
+                                         "30313233343536373839"
+                                         "40414243444546474849"
+                                         "50515253545556575859"
+                                         "60616263646566676869"
+                                         "70717273747576777879"
+                                         "80818283848586878889"
+                                         "90919293949596979899";
+
+// Writes the first KEY_DIGITS characters of "%016llu" without snprintf.
+static inline void format_key(uint64_t seed, char* key)
+{
+    if (seed >= 10000000000000000ULL) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%016llu", (unsigned long long)seed);
+        memcpy(key, buf, KEY_DIGITS);
+        return;
+    }
+    char* p = key + KEY_DIGITS;
+    for (int i = 0; i < KEY_DIGITS / 2; i++) {
+        p -= 2;
+        memcpy(p, key_digit_pairs + (seed % 100) * 2, 2);
+        seed /= 100;
+    }
+}
+
+// Per-thread key stream. Without Pregenerate() each Next() formats one key in
+// place; with it the whole sequence is formatted up front into a (huge-page
+// backed when possible) buffer and Next() only advances a pointer. Either way
+// the stream starts over after key_space keys (0 never rewinds).
+class KeyGenerator {
+public:
+    KeyGenerator(bool seq, uint64_t seed, uint64_t sequence_id, uint64_t key_space)
+        : seq(seq)
+        , seed(seed)
+        , sequence_id(sequence_id)
+        , key_space(key_space)
+        , cur_sequence_id(sequence_id)
+        , count(0)
+        , random(seed)
+        , buffer(nullptr)
+        , filter(nullptr)
+        , buffer_size(0)
+        , num_key(0)
+        , huge_page(false)
+    {
+        memset(key, 0, sizeof(key));
+    }
+
+    ~KeyGenerator()
+    {
+        if (buffer != nullptr) {
+            munmap(buffer, buffer_size);
+        }
+    }
+
+    // Materialises the first num_key keys, returns false (and keeps generating
+    // on the fly) if the buffer can not be mapped.
+    bool Pregenerate(uint64_t num)
+    {
+        if (num == 0) {
+            return false;
+        }
+        size_t size = num * (KEY_STRIDE + 1);
+        size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void* addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        huge_page = (addr != MAP_FAILED);
+        if (!huge_page) {
+            // no reserved huge pages, fall back to transparent huge pages.
+            addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr == MAP_FAILED) {
+                return false;
+            }
+            madvise(addr, size, MADV_HUGEPAGE);
+        }
+        buffer = (char*)addr;
+        buffer_size = size;
+        filter = buffer + num * KEY_STRIDE;
+        for (uint64_t i = 0; i < num; i++) {
+            uint64_t s = NextSeed();
+            char* k = buffer + i * KEY_STRIDE;
+            memset(k, 0, KEY_STRIDE);
+            format_key(s, k);
+            filter[i] = GET_FILTER(s);
+        }
+        num_key = num;
+        count = 0;
+        return true;
+    }
+
+    // Drops the first num keys of the stream, call it before Pregenerate().
+    void Skip(uint64_t num)
+    {
+        for (uint64_t i = 0; i < num; i++) {
+            NextSeed();
+        }
+    }
+
+    // Returns the next key (MAX_KEY_LENGTH bytes), *pass is GET_FILTER of its seed.
+    const char* Next(bool* pass)
+    {
+        if (num_key > 0) {
+            uint64_t i = count++ % num_key;
+            *pass = filter[i];
+            return buffer + i * KEY_STRIDE;
+        }
+        uint64_t s = NextSeed();
+        format_key(s, key);
+        *pass = GET_FILTER(s);
+        return key;
+    }
+
+    bool HugePage(void) const
+    {
+        return huge_page;
+    }
+
+private:
+    uint64_t NextSeed(void)
+    {
+        if (key_space > 0 && count > 0 && count % key_space == 0) {
+            cur_sequence_id = sequence_id;
+            random = Random(seed);
+        }
+        count++;
+        uint64_t s = seq ? cur_sequence_id : cur_sequence_id + random.Next();
+        cur_sequence_id++;
+        return s;
+    }
+
+private:
+    bool seq;
+    uint64_t seed;
+    uint64_t sequence_id;
+    uint64_t key_space;
+    uint64_t cur_sequence_id;
+    uint64_t count;
+    Random random;
+    char key[MAX_KEY_LENGTH + 8];
+
+    char* buffer; // num_key * KEY_STRIDE keys, then num_key filter flags
+    char* filter;
+    size_t buffer_size;
+    uint64_t num_key;
+    bool huge_page;
+};
+
+#endif
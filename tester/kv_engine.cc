@@ -0,0 +1,77 @@
+#include "kv_engine.h"
+
+struct kv_engine_entry_t {
+    const char* name;
+    kv_engine_factory_t factory;
+};
+
+// Function-local so registration from static initializers of other units is order-safe.
+static std::vector<kv_engine_entry_t>& kv_engine_table()
+{
+    static std::vector<kv_engine_entry_t> table;
+    return table;
+}
+
+bool RegisterKVEngine(const char* name, kv_engine_factory_t factory)
+{
+    kv_engine_entry_t entry;
+    entry.name = name;
+    entry.factory = factory;
+    kv_engine_table().push_back(entry);
+    return true;
+}
+
+KVEngine* NewKVEngine(const char* name)
+{
+    std::vector<kv_engine_entry_t>& table = kv_engine_table();
+    if (name == nullptr || name[0] == '\0') {
+        // without --engine= a single-engine binary picks the engine it was built with.
+        return (table.size() == 1) ? table[0].factory() : nullptr;
+    }
+    for (size_t i = 0; i < table.size(); i++) {
+        if (strcmp(table[i].name, name) == 0) {
+            return table[i].factory();
+        }
+    }
+    return nullptr;
+}
+
+int NumKVEngine()
+{
+    return kv_engine_table().size();
+}
+
+std::string ListKVEngine()
+{
+    std::string names;
+    std::vector<kv_engine_entry_t>& table = kv_engine_table();
+    for (size_t i = 0; i < table.size(); i++) {
+        if (i > 0) {
+            names.append(",");
+        }
+        names.append(table[i].name);
+    }
+    return names;
+}
+
+size_t KVEngine::MultiGet(const char* const* keys, const size_t* key_lengths, size_t num_keys, std::string* values, bool* found)
+{
+    size_t num_found = 0;
+    for (size_t i = 0; i < num_keys; i++) {
+        found[i] = Get(keys[i], key_lengths[i], &values[i]);
+        if (found[i]) {
+            num_found++;
+        }
+    }
+    return num_found;
+}
+
+KVIterator* KVEngine::NewIterator()
+{
+    return nullptr;
+}
+
+bool KVEngine::Counters(struct engine_stats_t* /* stats */)
+{
+    return false;
+}
@@ -0,0 +1,136 @@
+#ifndef INCLUDE_KV_ENGINE_H_
+#define INCLUDE_KV_ENGINE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "engine_stats.h"
+
+// Block compression asked of the engine, an adapter whose engine lacks the
+// codec logs it and writes uncompressed.
+#define COMPRESSION_NONE (0)
+#define COMPRESSION_SNAPPY (1)
+#define COMPRESSION_LZ4 (2)
+#define COMPRESSION_ZSTD (3)
+#define COMPRESSION_COUNT (4)
+
+static inline const char* compression_name(int compression)
+{
+    static const char* names[COMPRESSION_COUNT] = { "none", "snappy", "lz4", "zstd" };
+    return (compression >= 0 && compression < COMPRESSION_COUNT) ? names[compression] : "none";
+}
+
+// -1 for an unknown name.
+static inline int parse_compression(const char* name)
+{
+    for (int i = 0; i < COMPRESSION_COUNT; i++) {
+        if (strcmp(name, compression_name(i)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Engine-independent open options, every adapter picks the fields it understands.
+struct engine_options_t {
+public:
+    char db_path[128];
+    char nvm_path[128];
+    int num_backend_thread;
+    uint64_t max_file_size;
+    uint64_t write_buffer_size;
+    uint64_t nvm_buffer_size;
+    uint64_t pmem_file_size;
+    uint64_t bloom_bits;
+    uint64_t block_size;
+    int compression;
+    bool statistics; // keep engine counters for KVEngine::Counters where they cost the engine time
+
+public:
+    engine_options_t()
+    {
+        strcpy(db_path, "sst");
+        strcpy(nvm_path, "nvm");
+        num_backend_thread = 1;
+        max_file_size = 2 * 1024 * 1024;
+        write_buffer_size = 64 * 1024 * 1024;
+        nvm_buffer_size = (uint64_t)2 * 1024 * 1024 * 1024;
+        pmem_file_size = (uint64_t)2 * 1024 * 1024 * 1024;
+        bloom_bits = 10;
+        block_size = 4096;
+        compression = COMPRESSION_NONE;
+        statistics = false;
+    }
+};
+
+// One entry of KVEngine::WriteBatch (value is ignored for deletes).
+struct kv_write_t {
+    bool is_delete;
+    const char* key;
+    size_t key_length;
+    const char* value;
+    size_t value_length;
+};
+
+// Forward cursor over an engine. Value() points into engine memory and stays
+// valid until the next Seek() or Next(), so a scan can visit records without
+// copying them.
+class KVIterator {
+public:
+    virtual ~KVIterator() { }
+
+    virtual void Seek(const char* key, size_t key_length) = 0;
+    virtual bool Valid() = 0;
+    virtual void Next() = 0;
+    virtual const char* Value(size_t* value_length) = 0;
+};
+
+class KVEngine {
+public:
+    virtual ~KVEngine() { }
+
+    // Short name used by --engine= and for output directories.
+    virtual const char* Name() = 0;
+    virtual bool Open(const struct engine_options_t* options) = 0;
+    virtual void Close() = 0;
+
+public:
+    virtual bool Put(const char* key, size_t key_length, const char* value, size_t value_length) = 0;
+    virtual bool Get(const char* key, size_t key_length, std::string* value) = 0;
+    virtual bool Delete(const char* key, size_t key_length) = 0;
+    // Returns the number of keys visited, starting at the first key >= key.
+    virtual size_t Scan(const char* key, size_t key_length, size_t scan_range, std::vector<std::string>* values) = 0;
+    virtual bool WriteBatch(const struct kv_write_t* writes, size_t num_writes) = 0;
+    // Returns the number of keys found. The default issues one Get per key.
+    virtual size_t MultiGet(const char* const* keys, const size_t* key_lengths, size_t num_keys, std::string* values, bool* found);
+    // Iterator over the data at the time of the call (it does not see later
+    // writes), deleted by the caller before Close(). nullptr if unsupported.
+    virtual KVIterator* NewIterator();
+    // Engine-internal statistics in the engine's own text format.
+    virtual bool Stats(std::string* stats) = 0;
+    // Cumulative counters (engine_stats.h) for the per-phase diff, false if
+    // the engine keeps none. The default keeps none.
+    virtual bool Counters(struct engine_stats_t* stats);
+};
+
+typedef KVEngine* (*kv_engine_factory_t)();
+
+bool RegisterKVEngine(const char* name, kv_engine_factory_t factory);
+KVEngine* NewKVEngine(const char* name);
+int NumKVEngine();
+std::string ListKVEngine();
+
+// Every adapter translation unit registers itself, so a binary supports exactly the engines it links.
+#define REGISTER_KV_ENGINE(name, type)            \
+    static KVEngine* new_kv_engine_##type()       \
+    {                                             \
+        return new type();                        \
+    }                                             \
+    static bool kv_engine_registered_##type = RegisterKVEngine(name, new_kv_engine_##type);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef INCLUDE_LATENCY_FILE_H_
+#define INCLUDE_LATENCY_FILE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+// Raw latency samples of one thread and one op type, as written with
+// STORE_EACH_LATENCY and read by detail.cc: a latency_header_t followed by
+// num_sample uint64_t latencies (ns) in the order the ops were issued.
+#define LATENCY_MAGIC (0x3153544c564b4c4bULL) // "KLKVLTS1"
+#define LATENCY_VERSION (1)
+#define LATENCY_EXTENSION "lat"
+#define LATENCY_OP_NAME_LENGTH (16)
+
+struct latency_header_t {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t thread_id;
+    char op_name[LATENCY_OP_NAME_LENGTH];
+    uint64_t num_sample;
+    uint64_t reserved[3];
+};
+
+static inline bool write_latency_file(const char* path, int thread_id, const char* op_name, const std::vector<uint64_t>& samples)
+{
+    FILE* fout = fopen(path, "wb");
+    if (fout == nullptr) {
+        return false;
+    }
+    latency_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LATENCY_MAGIC;
+    header.version = LATENCY_VERSION;
+    header.thread_id = thread_id;
+    snprintf(header.op_name, sizeof(header.op_name), "%s", op_name);
+    header.num_sample = samples.size();
+    bool ok = fwrite(&header, sizeof(header), 1, fout) == 1;
+    if (ok && !samples.empty()) {
+        ok = fwrite(samples.data(), sizeof(uint64_t), samples.size(), fout) == samples.size();
+    }
+    return (fclose(fout) == 0) && ok;
+}
+
+#endif
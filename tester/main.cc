@@ -0,0 +1,661 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "easylogging/easylogging++.h"
+#include "io_stats.h"
+#include "kv_engine.h"
+#include "micro_benchmark.h"
+#include "pmem_emulator.h"
+#include "trace_recorder.h"
+#include "workload_spec.h"
+
+INITIALIZE_EASYLOGGINGPP
+
+static void split_engine_list(const char* list, std::vector<std::string>& names)
+{
+    std::string name;
+    for (const char* p = list; *p != '\0'; p++) {
+        if (*p == ',') {
+            if (!name.empty()) {
+                names.push_back(name);
+            }
+            name.clear();
+        } else if (*p != ' ') {
+            name.push_back(*p);
+        }
+    }
+    if (!name.empty()) {
+        names.push_back(name);
+    }
+}
+
+// What the engine did during one phase (engine_stats.h), logged after the
+// phase's own results. Nothing for an engine without counters.
+static void log_engine_stats(KVEngine* db, const char* phase, const engine_stats_t& before)
+{
+    engine_stats_t after;
+    if (db->Counters(&after)) {
+        engine_stats_t diff = engine_stats_t::Diff(before, after);
+        if (!diff.Empty()) {
+            LOG(INFO) << "|- [ENGINE:" << phase << "]" << diff.ToString();
+        }
+    }
+}
+
+// What a finished phase asked of the engine, for the I/O accounting.
+static io_user_t user_io_of(const struct benchmark_param_t& param)
+{
+    io_user_t user;
+    user.puts = param.num_found[TEST_PUT];
+    user.put_bytes = param.put_bytes;
+    user.deletes = param.num_found[TEST_DELETE];
+    user.delete_bytes = param.num_found[TEST_DELETE] * param.key_length;
+    user.gets = param.latency[TEST_GET].Count() + param.latency[TEST_MULTIGET].Count() * param.multiget_batch;
+    return user;
+}
+
+// Logs the I/O and amplification of the phase since io->Begin(), overwrite
+// when its puts only rewrote keys that were already there.
+static void log_io_phase(IoAccountant* io, const char* phase, const io_user_t& user, bool overwrite)
+{
+    if (io->Enabled()) {
+        LOG(INFO) << "|- [IO:" << phase << "]" << io->End(user, overwrite);
+    }
+}
+
+// Everything the engine did since it was opened, logged before it closes.
+static void log_io_total(IoAccountant* io, KVEngine* db)
+{
+    if (io->Enabled()) {
+        LOG(INFO) << "|- [IO:" << db->Name() << "]" << io->Total();
+    }
+}
+
+// What the emulated persistent memory was charged, nullptr when it is off.
+static void log_pmem_total(PmemEmulator* emulator)
+{
+    if (emulator != nullptr) {
+        LOG(INFO) << "|- [PMEM:" << emulator->Name() << "]" << emulator->Device()->ToString();
+    }
+}
+
+// Requests left out of the trace, nullptr when none is recorded. Their keys
+// do not fit a trace record, so a replay of it does not send them.
+static void log_trace_total(TraceRecorder* recorder)
+{
+    if (recorder != nullptr && recorder->NumRejected() > 0) {
+        LOG(INFO) << "|- [TRACE_RECORD] " << recorder->NumRejected() << " requests with keys over " << TRACE_MAX_KEY_LENGTH << "B were left out!";
+    }
+}
+
+// Deletes num_delete_opt keys of the warmup in tombstone_rounds equal steps and
+// runs the get/scan mix of test_param before the first step and after each one,
+// so read latency can be followed as tombstones pile up. Adds what all the
+// rounds asked of the engine to *user.
+static void run_tombstone_rounds(KVEngine* db, const struct benchmark_param_t& test_param, uint64_t tombstone_rounds, const char* report_file, io_user_t* user)
+{
+    struct benchmark_param_t read_param = test_param;
+    read_param.num_put_opt = 0;
+    read_param.num_delete_opt = 0;
+
+    struct benchmark_param_t delete_param = test_param;
+    delete_param.num_put_opt = 0;
+    delete_param.num_get_opt = 0;
+    delete_param.num_scan_opt = 0;
+    delete_param.num_multiget_opt = 0;
+    delete_param.num_delete_opt = test_param.num_delete_opt / tombstone_rounds;
+    delete_param.duration = 0;
+    delete_param.target_qps = 0;
+    delete_param.arrival = ARRIVAL_CLOSED;
+    uint64_t num_delete_per_thread = delete_param.num_delete_opt / test_param.num_thread;
+
+    std::vector<std::string> summary;
+    uint64_t num_deleted = 0;
+    for (uint64_t round = 0; round <= tombstone_rounds; round++) {
+        if (round > 0) {
+            // every round deletes the keys following the ones of the round before.
+            delete_param.delete_skip = (round - 1) * num_delete_per_thread;
+            snprintf(delete_param.report_file, sizeof(delete_param.report_file), "%s_%s_delete%llu.%s", report_file, db->Name(), (unsigned long long)round, Reporter::Extension(test_param.report_format));
+            MicroBenchmark delete_benchmark(&delete_param, db);
+            delete_benchmark.Run();
+            num_deleted += delete_param.num_found[TEST_DELETE];
+            user->Add(user_io_of(delete_param));
+        }
+        snprintf(read_param.report_file, sizeof(read_param.report_file), "%s_%s_read%llu.%s", report_file, db->Name(), (unsigned long long)round, Reporter::Extension(test_param.report_format));
+        MicroBenchmark read_benchmark(&read_param, db);
+        read_benchmark.Run();
+        user->Add(user_io_of(read_param));
+
+        const Histogram& get = read_param.latency[TEST_GET];
+        const Histogram& scan = read_param.latency[TEST_SCAN];
+        char buf[256];
+        snprintf(buf, sizeof(buf), "|- [ROUND:%llu][DELETED:%llu][GET:%lluns/%lluns][FOUND:%llu/%llu][SCAN:%lluns/%lluns][RECORDS:%llu/%llu]",
+            (unsigned long long)round, (unsigned long long)num_deleted, (unsigned long long)get.Average(), (unsigned long long)get.Percentile(0.99),
+            (unsigned long long)read_param.num_found[TEST_GET], (unsigned long long)get.Count(), (unsigned long long)scan.Average(),
+            (unsigned long long)scan.Percentile(0.99), (unsigned long long)read_param.num_found[TEST_SCAN], (unsigned long long)scan.Count());
+        summary.push_back(buf);
+    }
+
+    LOG(INFO) << "|----------[Tombstone]----------------------";
+    LOG(INFO) << "|- [ROUND][DELETED][GET:avg/p99][FOUND:found/gets][SCAN:avg/p99][RECORDS:records/scans]";
+    for (size_t i = 0; i < summary.size(); i++) {
+        LOG(INFO) << summary[i];
+    }
+    LOG(INFO) << "|-------------------------------------------";
+}
+
+// Runs the phases of a workload spec back to back on one open engine. The first
+// phase with puts loads the data on the warmup key streams, its distribution
+// (sequential or uniform random) fixes the key order of the whole spec, and the
+// gets/deletes/scans/updates of every later phase walk those streams again. The
+// tester has no skewed key streams and no read-modify-write, those phases run
+// uniform and without their rmw share.
+static void run_workload_spec(KVEngine* db, const WorkloadSpec& spec, const struct benchmark_param_t& base, uint64_t seed, const char* report_file, IoAccountant* io)
+{
+    std::vector<uint64_t> loaded; // keys written on each load stream
+    bool seq = false;
+    std::vector<std::string> summary;
+    for (size_t p = 0; p < spec.phases.size(); p++) {
+        const phase_spec_t& phase = spec.phases[p];
+        int num_thread = (phase.num_thread > 0) ? phase.num_thread : base.num_thread;
+        bool is_load = loaded.empty() && (phase.mix[SPEC_PUT] > 0 || phase.mix[SPEC_UPDATE] > 0);
+        if (is_load) {
+            seq = (phase.distribution == "sequential");
+        }
+        const char* stream = seq ? "sequential" : "uniform";
+        if (phase.distribution != stream) {
+            LOG(INFO) << "|- [" << phase.name << "] runs " << stream << " keys instead of " << phase.distribution << " in the tester.";
+        }
+        if (phase.mix[SPEC_RMW] > 0) {
+            LOG(INFO) << "|- [" << phase.name << "] has rmw, which only ycsb-example runs.";
+        }
+
+        struct benchmark_param_t param = base;
+        param.SetNumThread(num_thread);
+        param.seq = seq;
+        param.key_length = phase.key_length;
+        ValueSize value_size;
+        std::string error;
+        value_size.Parse(phase.value_size.c_str(), &error); // checked by WorkloadSpec::Load
+        value_size.Clamp(MAX_KEY_LENGTH, MAX_VALUE_LENGTH);
+        param.value_length = value_size.Max();
+        param.value_size = value_size.Fixed() ? nullptr : &value_size;
+        param.num_put_opt = phase.OpsOf(SPEC_PUT) + phase.OpsOf(SPEC_UPDATE);
+        param.num_get_opt = phase.OpsOf(SPEC_GET);
+        param.num_delete_opt = phase.OpsOf(SPEC_DELETE);
+        param.num_scan_opt = phase.OpsOf(SPEC_SCAN);
+        param.num_multiget_opt = phase.OpsOf(SPEC_MULTIGET);
+        param.scan_range = phase.scan_range;
+        param.target_qps = phase.target_qps;
+        param.arrival = (phase.target_qps > 0) ? phase.arrival : ARRIVAL_CLOSED;
+        param.duration = phase.duration;
+        // updates alone overwrite the loaded keys, new puts get streams of their own.
+        bool put_on_load = is_load || phase.mix[SPEC_PUT] == 0;
+        for (int i = 0; i < num_thread; i++) {
+            int l = loaded.empty() ? i : i % (int)loaded.size();
+            uint64_t load_seed = seed + (uint64_t)123456789 * (l + 1);
+            uint64_t load_sequence_id = (uint64_t)(l + 1) * 987654321;
+            if (put_on_load) {
+                param.put_seed[i] = load_seed;
+                param.put_sequence_id[i] = load_sequence_id;
+            } else {
+                param.put_seed[i] = seed + (uint64_t)777777777 * (i + 1) + p * 1000003;
+                param.put_sequence_id[i] = (uint64_t)(i + 1) * 666666666 + p * 1000003;
+            }
+            param.get_seed[i] = param.delete_seed[i] = param.scan_seed[i] = load_seed;
+            param.get_sequence_id[i] = param.delete_sequence_id[i] = param.scan_sequence_id[i] = load_sequence_id;
+            param.key_space[i] = loaded.empty() ? 0 : loaded[l];
+        }
+        snprintf(param.report_file, sizeof(param.report_file), "%s_%s_%s.%s", report_file, db->Name(), phase.name.c_str(), Reporter::Extension(base.report_format));
+
+        LOG(INFO) << "|----------[Phase:" << phase.name << "]----------------------";
+        engine_stats_t phase_stats;
+        db->Counters(&phase_stats);
+        io->Begin();
+        MicroBenchmark benchmark(&param, db);
+        benchmark.Run();
+        log_engine_stats(db, phase.name.c_str(), phase_stats);
+        log_io_phase(io, phase.name.c_str(), user_io_of(param), put_on_load && !is_load);
+        if (is_load) {
+            loaded = param.num_put_done;
+        }
+
+        uint64_t count = 0;
+        for (int t = 0; t < TEST_TYPE_COUNT; t++) {
+            count += param.latency[t].Count();
+        }
+        const Histogram& get = param.latency[TEST_GET];
+        char buf[256];
+        snprintf(buf, sizeof(buf), "|- [%s][THREAD:%d][OPS:%llu][PUT:%llu][GET:%lluns/%lluns][FOUND:%llu/%llu]",
+            phase.name.c_str(), num_thread, (unsigned long long)count, (unsigned long long)param.latency[TEST_PUT].Count(), (unsigned long long)get.Average(),
+            (unsigned long long)get.Percentile(0.99), (unsigned long long)param.num_found[TEST_GET], (unsigned long long)get.Count());
+        summary.push_back(buf);
+    }
+
+    LOG(INFO) << "|----------[Workload]-----------------------";
+    LOG(INFO) << "|- [PHASE][THREAD][OPS][PUT][GET:avg/p99][FOUND:found/gets]";
+    for (size_t i = 0; i < summary.size(); i++) {
+        LOG(INFO) << summary[i];
+    }
+    LOG(INFO) << "|-------------------------------------------";
+}
+
+int main(int argc, char* argv[])
+{
+    struct benchmark_param_t warm_param;
+    struct benchmark_param_t test_param;
+    struct engine_options_t engine_options;
+    char engine_list[128] = "";
+    char db_path[128] = "sst";
+    char nvm_path[128] = "nvm";
+    size_t key_length = 16;
+    size_t value_length = 1024;
+    ValueSize value_size;
+    bool variable_value = false;
+    double compression_ratio = 0;
+    int compression = COMPRESSION_NONE;
+    int engine_statistics = 0;
+    int io_stats = 1;
+    pmem_emulation_t pmem;
+    int seq = 0;
+    int num_server_thread = 1;
+    int num_backend_thread = 1;
+    uint64_t num_warm_opt = 500000;
+    uint64_t num_put_opt = 0;
+    uint64_t num_get_opt = 0;
+    uint64_t num_delete_opt = 0;
+    uint64_t num_scan_opt = 0;
+    uint64_t num_multiget_opt = 0;
+    uint64_t multiget_batch = 16;
+    uint64_t scan_range = 1000;
+    uint64_t tombstone_rounds = 0;
+    int scan_iterator_reuse = 0;
+    int scan_zero_copy = 0;
+    uint64_t batch_size = 0;
+    uint64_t batch_bytes = 0;
+    uint64_t target_qps = 0;
+    int arrival = ARRIVAL_CONSTANT;
+    uint64_t report_interval_ms = 0;
+    int report_format = REPORT_CSV;
+    char report_file[128] = "timeline";
+    uint64_t duration = 0;
+    uint64_t warmup_duration = 0;
+    uint64_t steady_window_ms = 0;
+    uint64_t steady_windows = 5;
+    double steady_cv = 0.05;
+    int pregenerate_keys = 0;
+    int perf_counters = 0;
+    int placement_policy = PLACEMENT_NONE;
+    char cpu_list[256] = "";
+    char trace_record[256] = "";
+    char workload_file[256] = "";
+    uint64_t seed = 1000;
+    uint64_t max_file_size = 2 * 1024 * 1024;
+    uint64_t nvm_buffer_size = (size_t)2 * 1024 * 1024 * 1024;
+    uint64_t write_buffer_size = 64 * 1024 * 1024;
+    uint64_t bloom_bits = 10;
+    uint64_t block_size = 4096;
+    uint64_t pmem_file_size = (uint64_t)2 * 1024 * 1024 * 1024;
+
+    for (int i = 0; i < argc; i++) {
+        double d;
+        uint64_t n;
+        char junk;
+
+        if (sscanf(argv[i], "--pmem_file_size=%llu%c", &n, &junk) == 1) {
+            pmem_file_size = n * 1024 * 1024; // MB
+        } else if (sscanf(argv[i], "--key_length=%llu%c", &n, &junk) == 1) {
+            key_length = n;
+            assert(key_length <= MAX_KEY_LENGTH);
+        } else if (sscanf(argv[i], "--value_length=%llu%c", &n, &junk) == 1) {
+            value_length = n;
+            assert(value_length <= MAX_VALUE_LENGTH);
+        } else if (strncmp(argv[i], "--value_size=", 13) == 0) {
+            std::string error;
+            if (!value_size.Parse(argv[i] + 13, &error)) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]: " << error << "!";
+                return 0;
+            }
+            variable_value = true;
+        } else if (sscanf(argv[i], "--compression_ratio=%lf%c", &d, &junk) == 1) {
+            compression_ratio = d;
+            assert(compression_ratio >= 0 && compression_ratio <= 1);
+        } else if (sscanf(argv[i], "--io_stats=%llu%c", &n, &junk) == 1) {
+            io_stats = n;
+        } else if (strncmp(argv[i], "--pmem_emulate=", 15) == 0) {
+            snprintf(pmem.dir, sizeof(pmem.dir), "%s", argv[i] + 15);
+        } else if (sscanf(argv[i], "--pmem_read_latency_ns=%llu%c", &n, &junk) == 1) {
+            pmem.read_latency_ns = n;
+        } else if (sscanf(argv[i], "--pmem_write_latency_ns=%llu%c", &n, &junk) == 1) {
+            pmem.write_latency_ns = n;
+        } else if (sscanf(argv[i], "--pmem_read_bandwidth=%llu%c", &n, &junk) == 1) {
+            pmem.read_bandwidth_mb = n;
+        } else if (sscanf(argv[i], "--pmem_write_bandwidth=%llu%c", &n, &junk) == 1) {
+            pmem.write_bandwidth_mb = n;
+        } else if (sscanf(argv[i], "--engine_stats=%llu%c", &n, &junk) == 1) {
+            engine_statistics = n;
+        } else if (strncmp(argv[i], "--compression=", 14) == 0) {
+            compression = parse_compression(argv[i] + 14);
+            if (compression < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]!";
+                return 0;
+            }
+        } else if (sscanf(argv[i], "--num_server_thread=%llu%c", &n, &junk) == 1) {
+            num_server_thread = n;
+        } else if (sscanf(argv[i], "--num_backend_thread=%llu%c", &n, &junk) == 1) {
+            num_backend_thread = n;
+        } else if (sscanf(argv[i], "--num_warm=%llu%c", &n, &junk) == 1) {
+            num_warm_opt = n;
+        } else if (sscanf(argv[i], "--num_put=%llu%c", &n, &junk) == 1) {
+            num_put_opt = n;
+        } else if (sscanf(argv[i], "--num_get=%llu%c", &n, &junk) == 1) {
+            num_get_opt = n;
+        } else if (sscanf(argv[i], "--num_delete=%llu%c", &n, &junk) == 1) {
+            num_delete_opt = n;
+        } else if (sscanf(argv[i], "--num_scan=%llu%c", &n, &junk) == 1) {
+            num_scan_opt = n;
+        } else if (sscanf(argv[i], "--num_multiget=%llu%c", &n, &junk) == 1) {
+            num_multiget_opt = n;
+        } else if (sscanf(argv[i], "--multiget_batch=%llu%c", &n, &junk) == 1) {
+            multiget_batch = n;
+            assert(multiget_batch > 0);
+        } else if (sscanf(argv[i], "--scan_range=%llu%c", &n, &junk) == 1) {
+            scan_range = n;
+        } else if (sscanf(argv[i], "--scan_iterator_reuse=%llu%c", &n, &junk) == 1) {
+            scan_iterator_reuse = n;
+        } else if (sscanf(argv[i], "--scan_zero_copy=%llu%c", &n, &junk) == 1) {
+            scan_zero_copy = n;
+        } else if (sscanf(argv[i], "--batch_size=%llu%c", &n, &junk) == 1) {
+            batch_size = n;
+        } else if (sscanf(argv[i], "--batch_bytes=%llu%c", &n, &junk) == 1) {
+            batch_bytes = n;
+        } else if (sscanf(argv[i], "--tombstone_rounds=%llu%c", &n, &junk) == 1) {
+            tombstone_rounds = n;
+        } else if (sscanf(argv[i], "--target_qps=%llu%c", &n, &junk) == 1) {
+            target_qps = n;
+        } else if (strncmp(argv[i], "--arrival=", 10) == 0) {
+            arrival = Arrival::Parse(argv[i] + 10);
+            if (arrival < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]!";
+                return 0;
+            }
+        } else if (sscanf(argv[i], "--report_interval_ms=%llu%c", &n, &junk) == 1) {
+            report_interval_ms = n;
+        } else if (strncmp(argv[i], "--report_format=", 16) == 0) {
+            report_format = Reporter::ParseFormat(argv[i] + 16);
+            if (report_format < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]!";
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--report_file=", 14) == 0) {
+            strcpy(report_file, argv[i] + 14);
+        } else if (sscanf(argv[i], "--duration=%llu%c", &n, &junk) == 1) {
+            duration = n;
+        } else if (sscanf(argv[i], "--warmup_duration=%llu%c", &n, &junk) == 1) {
+            warmup_duration = n;
+        } else if (sscanf(argv[i], "--steady_window_ms=%llu%c", &n, &junk) == 1) {
+            steady_window_ms = n;
+        } else if (sscanf(argv[i], "--steady_windows=%llu%c", &n, &junk) == 1) {
+            steady_windows = n;
+            assert(steady_windows > 1);
+        } else if (sscanf(argv[i], "--steady_cv=%lf%c", &d, &junk) == 1) {
+            steady_cv = d;
+        } else if (sscanf(argv[i], "--pregenerate_keys=%llu%c", &n, &junk) == 1) {
+            pregenerate_keys = n;
+        } else if (sscanf(argv[i], "--perf_counters=%llu%c", &n, &junk) == 1) {
+            perf_counters = n;
+        } else if (strncmp(argv[i], "--numa_policy=", 14) == 0) {
+            placement_policy = ThreadPlacement::ParsePolicy(argv[i] + 14);
+            if (placement_policy < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]!";
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--cpu_list=", 11) == 0) {
+            snprintf(cpu_list, sizeof(cpu_list), "%s", argv[i] + 11);
+        } else if (sscanf(argv[i], "--seed=%llu%c", &n, &junk) == 1) {
+            seed = n;
+        } else if (sscanf(argv[i], "--seq=%llu%c", &n, &junk) == 1) {
+            seq = n;
+        } else if (sscanf(argv[i], "--max_file_size=%llu%c", &n, &junk) == 1) {
+            max_file_size = (uint64_t)n * 1024 * 1024;
+        } else if (sscanf(argv[i], "--write_buffer_size=%llu%c", &n, &junk) == 1) {
+            write_buffer_size = (uint64_t)n * 1024 * 1024;
+        } else if (sscanf(argv[i], "--nvm_buffer_size=%llu%c", &n, &junk) == 1) {
+            nvm_buffer_size = (uint64_t)n * 1024 * 1024;
+        } else if (sscanf(argv[i], "--bloom_bits=%llu%c", &n, &junk) == 1) {
+            bloom_bits = n;
+        } else if (strncmp(argv[i], "--db=", 5) == 0) {
+            strcpy(db_path, argv[i] + 5);
+        } else if (strncmp(argv[i], "--nvm=", 6) == 0) {
+            strcpy(nvm_path, argv[i] + 6);
+        } else if (strncmp(argv[i], "--engine=", 9) == 0) {
+            strcpy(engine_list, argv[i] + 9);
+        } else if (strncmp(argv[i], "--trace_record=", 15) == 0) {
+            snprintf(trace_record, sizeof(trace_record), "%s", argv[i] + 15);
+        } else if (strncmp(argv[i], "--workload=", 11) == 0) {
+            snprintf(workload_file, sizeof(workload_file), "%s", argv[i] + 11);
+        } else if (i > 0) {
+            LOG(INFO) << "Error Parameter [" << argv[i] << "]!";
+            return 0;
+        }
+    }
+
+    WorkloadSpec spec;
+    if (workload_file[0] != '\0') {
+        std::string error;
+        if (!spec.Load(workload_file, &error)) {
+            LOG(INFO) << "Can not load workload [" << workload_file << "]: " << error << "!";
+            return 0;
+        }
+        LOG(INFO) << "|- [WORKLOAD:" << workload_file << "][PHASE:" << spec.phases.size() << "]";
+    }
+
+    std::vector<std::string> engine_names;
+    split_engine_list(engine_list, engine_names);
+    if (engine_names.empty()) {
+        if (NumKVEngine() != 1) {
+            LOG(INFO) << "Please choose an engine with --engine=[" << ListKVEngine() << "]!";
+            return 0;
+        }
+        engine_names.push_back(std::string());
+    }
+
+    engine_options.num_backend_thread = num_backend_thread;
+    engine_options.max_file_size = max_file_size;
+    engine_options.write_buffer_size = write_buffer_size;
+    engine_options.nvm_buffer_size = nvm_buffer_size;
+    engine_options.pmem_file_size = pmem_file_size;
+    engine_options.bloom_bits = bloom_bits;
+    engine_options.block_size = block_size;
+    engine_options.compression = compression;
+    engine_options.statistics = engine_statistics;
+    strcpy(engine_options.nvm_path, nvm_path);
+    if (pmem.dir[0] != '\0') {
+        const char* fs_name;
+        std::string error;
+        if (!PmemEmulator::Place(pmem.dir, nvm_path, engine_options.nvm_path, sizeof(engine_options.nvm_path), &fs_name, &error)) {
+            LOG(INFO) << "Can not emulate persistent memory: " << error << "!";
+            return 0;
+        }
+        LOG(INFO) << "|- [PMEM:" << engine_options.nvm_path << "(" << fs_name << ")][READ:" << pmem.read_latency_ns << "ns/" << pmem.read_bandwidth_mb
+                  << "MB/s][WRITE:" << pmem.write_latency_ns << "ns per line/" << pmem.write_bandwidth_mb << "MB/s]";
+    }
+
+    // a cpu list wins over numa_policy wherever either comes on the command line.
+    if (cpu_list[0] != '\0') {
+        placement_policy = PLACEMENT_CPU_LIST;
+    }
+    ThreadPlacement placement;
+    if (!placement.Init(placement_policy, cpu_list)) {
+        LOG(INFO) << "Can not place threads with [" << ThreadPlacement::PolicyName(placement_policy) << "][" << cpu_list << "]!";
+        return 0;
+    }
+    if (placement_policy != PLACEMENT_NONE) {
+        LOG(INFO) << "|- [PLACEMENT:" << ThreadPlacement::PolicyName(placement_policy) << "][NODE:" << placement.NumNode() << "]";
+    }
+    // calibrates the clock once, before any worker starts timing.
+    LOG(INFO) << "|- [CLOCK:" << TscClock::Get().Source() << "][TSC:" << TscClock::Get().GHz() << "GHz]";
+
+    warm_param.SetNumThread(num_server_thread);
+    warm_param.placement = &placement;
+    warm_param.seq = seq;
+    warm_param.num_put_opt = num_warm_opt;
+    warm_param.key_length = key_length;
+    warm_param.value_length = value_length;
+    warm_param.report_interval_ms = report_interval_ms;
+    warm_param.report_format = report_format;
+    warm_param.duration = warmup_duration;
+    warm_param.steady_window_ms = steady_window_ms;
+    warm_param.steady_windows = steady_windows;
+    warm_param.steady_cv = steady_cv;
+    warm_param.pregenerate_keys = pregenerate_keys;
+    warm_param.batch_size = batch_size;
+    warm_param.batch_bytes = batch_bytes;
+    // every value has room for its key, which puts stamp into it.
+    value_size.Clamp(MAX_KEY_LENGTH, MAX_VALUE_LENGTH);
+    warm_param.value_size = variable_value ? &value_size : nullptr;
+    warm_param.compression_ratio = compression_ratio;
+
+    for (int i = 0; i < num_server_thread; i++) {
+        warm_param.put_seed[i] = seed + (uint64_t)123456789 * (i + 1);
+        warm_param.put_sequence_id[i] = (uint64_t)(i + 1) * 987654321;
+    }
+
+    test_param.SetNumThread(num_server_thread);
+    test_param.placement = &placement;
+    test_param.num_put_opt = num_put_opt;
+    test_param.num_get_opt = num_get_opt;
+    test_param.num_delete_opt = num_delete_opt;
+    test_param.num_scan_opt = num_scan_opt;
+    test_param.num_multiget_opt = num_multiget_opt;
+    test_param.multiget_batch = multiget_batch;
+    test_param.scan_range = scan_range;
+    test_param.scan_iterator_reuse = scan_iterator_reuse;
+    test_param.scan_zero_copy = scan_zero_copy;
+    test_param.batch_size = batch_size;
+    test_param.batch_bytes = batch_bytes;
+    test_param.target_qps = target_qps;
+    test_param.arrival = (target_qps > 0) ? arrival : ARRIVAL_CLOSED;
+    test_param.seq = seq;
+    test_param.key_length = key_length;
+    test_param.value_length = value_length;
+    test_param.report_interval_ms = report_interval_ms;
+    test_param.report_format = report_format;
+    test_param.duration = duration;
+    test_param.pregenerate_keys = pregenerate_keys;
+    test_param.perf_counters = perf_counters;
+    test_param.value_size = warm_param.value_size;
+    test_param.compression_ratio = compression_ratio;
+
+    for (int i = 0; i < num_server_thread; i++) {
+        test_param.put_seed[i] = seed + (uint64_t)777777777 * (i + 1);
+        test_param.put_sequence_id[i] = (uint64_t)(i + 1) * 666666666;
+        test_param.get_seed[i] = warm_param.put_seed[i];
+        test_param.get_sequence_id[i] = warm_param.put_sequence_id[i];
+        test_param.delete_seed[i] = warm_param.put_seed[i];
+        test_param.delete_sequence_id[i] = warm_param.put_sequence_id[i];
+        test_param.scan_seed[i] = warm_param.put_seed[i];
+        test_param.scan_sequence_id[i] = warm_param.put_sequence_id[i];
+    }
+
+    for (size_t e = 0; e < engine_names.size(); e++) {
+        KVEngine* db = NewKVEngine(engine_names[e].c_str());
+        if (db == nullptr) {
+            LOG(INFO) << "Unknown engine [" << engine_names[e] << "], available engines [" << ListKVEngine() << "]!";
+            return 0;
+        }
+        // engines compared back to back in one run never share a data directory.
+        if (engine_names.size() > 1) {
+            snprintf(engine_options.db_path, sizeof(engine_options.db_path), "%s_%s", db_path, db->Name());
+        } else {
+            strcpy(engine_options.db_path, db_path);
+        }
+        if (variable_value) {
+            LOG(INFO) << "|- [engine:" << db->Name() << "][key length:" << key_length << "B][value size:" << value_size.ToString() << "]";
+        } else {
+            LOG(INFO) << "|- [engine:" << db->Name() << "][key/value length:" << key_length << "B/" << value_length << "B]";
+        }
+        PmemEmulator* emulator = nullptr;
+        if (pmem.dir[0] != '\0') {
+            emulator = new PmemEmulator(db, pmem);
+            db = emulator;
+        }
+        TraceRecorder* recorder = nullptr;
+        if (trace_record[0] != '\0') {
+            char trace_path[512];
+            if (engine_names.size() > 1) {
+                snprintf(trace_path, sizeof(trace_path), "%s_%s", trace_record, db->Name());
+            } else {
+                snprintf(trace_path, sizeof(trace_path), "%s", trace_record);
+            }
+            recorder = new TraceRecorder(db);
+            if (!recorder->OpenTrace(trace_path)) {
+                LOG(INFO) << "Can not create trace [" << trace_path << "]!";
+                delete recorder;
+                return 0;
+            }
+            db = recorder;
+            LOG(INFO) << "|- [TRACE_RECORD:" << trace_path << "]";
+        }
+        bool ok = db->Open(&engine_options);
+        assert(ok);
+        IoAccountant io;
+        if (io_stats) {
+            io.Init(engine_options.db_path, engine_options.nvm_path);
+            LOG(INFO) << "|- [IO]" << io.ToString();
+        }
+        snprintf(warm_param.report_file, sizeof(warm_param.report_file), "%s_%s_warm.%s", report_file, db->Name(), Reporter::Extension(report_format));
+        snprintf(test_param.report_file, sizeof(test_param.report_file), "%s_%s_run.%s", report_file, db->Name(), Reporter::Extension(report_format));
+
+        // a workload spec brings its own load phase, it replaces warmup and test.
+        if (!spec.phases.empty()) {
+            run_workload_spec(db, spec, test_param, seed, report_file, &io);
+            log_io_total(&io, db);
+            log_pmem_total(emulator);
+            log_trace_total(recorder);
+            db->Close();
+            delete db;
+            continue;
+        }
+
+        engine_stats_t warm_stats;
+        db->Counters(&warm_stats);
+        io.Begin();
+        MicroBenchmark* warm_benchmark = new MicroBenchmark(&warm_param, db);
+        warm_benchmark->Run();
+        log_engine_stats(db, "warm", warm_stats);
+        log_io_phase(&io, "warm", user_io_of(warm_param), false);
+        // a warmup cut short (or run longer) by time only loaded what its threads got through.
+        if (warm_param.duration > 0 || warm_param.steady_window_ms > 0) {
+            for (int i = 0; i < num_server_thread; i++) {
+                test_param.key_space[i] = warm_param.num_put_done[i];
+            }
+        }
+
+        engine_stats_t run_stats;
+        db->Counters(&run_stats);
+        io.Begin();
+        io_user_t run_user;
+        if (tombstone_rounds > 0) {
+            run_tombstone_rounds(db, test_param, tombstone_rounds, report_file, &run_user);
+        } else {
+            MicroBenchmark* test_benchmark = new MicroBenchmark(&test_param, db);
+            test_benchmark->Run();
+            run_user = user_io_of(test_param);
+            delete test_benchmark;
+        }
+        log_engine_stats(db, "run", run_stats);
+        log_io_phase(&io, "run", run_user, false);
+        log_io_total(&io, db);
+        log_pmem_total(emulator);
+        log_trace_total(recorder);
+
+        delete warm_benchmark;
+        db->Close();
+        delete db;
+    }
+    return 0;
+}
@@ -0,0 +1,1024 @@
+#include "micro_benchmark.h"
+#include "batch_buffer.h"
+#include "config.h"
+#include "easylogging/easylogging++.h"
+#include "histogram.h"
+#include "latency_file.h"
+#include "key_generator.h"
+#include "perf_counter.h"
+#include "random.h"
+#include "steady_state.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+static const char* test_type_name[TEST_TYPE_COUNT] = { "PUT", "GET", "DELETE", "SCAN", "MULTIGET" };
+
+struct thread_result_t {
+    uint64_t iops;
+    uint64_t latency;
+    uint64_t throughput;
+    uint64_t count[TEST_TYPE_COUNT];
+    uint64_t service_time[TEST_TYPE_COUNT]; // sum of engine call latency
+    uint64_t response_time[TEST_TYPE_COUNT]; // sum of latency since the intended send time
+    uint64_t found[TEST_TYPE_COUNT]; // see benchmark_param_t::num_found
+    uint64_t bytes; // key and value bytes moved
+    uint64_t put_bytes; // key and value bytes of the puts that succeeded
+    uint64_t start_ns; // when the thread left the start barrier
+    uint64_t end_ns; // when the thread issued its last op
+    uint64_t scan_keys; // records visited by scans
+    uint64_t scan_bytes; // value bytes visited by scans
+    uint64_t iterator_count; // iterators created for scans
+    uint64_t iterator_time; // sum of their creation latency
+    uint64_t batch_keys; // puts/deletes written through WriteBatch
+    uint64_t batch_time; // sum of WriteBatch latency
+    uint64_t multiget_keys; // keys looked up by MultiGet batches
+    uint64_t perf[TEST_TYPE_COUNT][PERF_NUM_COUNTER]; // hardware counts of the timed regions
+    int perf_mask; // counters the thread could open, see PerfCounters::Mask
+    bool perf_rdpmc;
+    bool perf_user_only;
+    bool perf_multiplexed;
+    const char* perf_error; // why the counters did not open
+};
+
+struct thread_test_t {
+    bool seq;
+    int thread_id;
+    size_t key_length;
+    size_t value_length;
+    uint64_t num_get_opt;
+    uint64_t get_seed;
+    uint64_t get_sequence_id;
+    uint64_t num_put_opt;
+    uint64_t put_seed;
+    uint64_t put_sequence_id;
+    uint64_t num_delete_opt;
+    uint64_t delete_seed;
+    uint64_t delete_sequence_id;
+    uint64_t num_scan_opt;
+    uint64_t scan_range;
+    uint64_t scan_seed;
+    uint64_t scan_sequence_id;
+    uint64_t num_multiget_opt;
+    size_t multiget_batch;
+    bool scan_iterator_reuse;
+    bool scan_zero_copy;
+    size_t batch_size;
+    size_t batch_bytes;
+    double target_qps;
+    int arrival;
+    bool timed; // run until *stop instead of the op counts
+    uint64_t key_space;
+    uint64_t delete_skip;
+    bool pregenerate_keys;
+    const ValueSize* value_size;
+    double compression_ratio;
+    bool perf_counters;
+};
+
+// Each thread writes only its own (cache-line aligned) entry.
+struct alignas(CACHE_LINE_SIZE) thread_param_t {
+    KVEngine* db;
+    const ThreadPlacement* placement;
+    Histogram* histogram; // [TEST_TYPE_COUNT], allocated by the thread, freed by MicroBenchmark::Run
+    Histogram* batch_histogram; // latency of whole WriteBatch calls, same ownership
+    const bool* stop; // set once the phase deadline passes or throughput is steady
+    int* num_finished;
+    pthread_barrier_t* barrier; // all threads and the main thread start together
+    thread_param_t** local; // where the thread publishes the entry it works on
+    thread_test_t test;
+    thread_result_t result;
+};
+
+// Dump every raw sample besides the histograms (memory grows with the op count).
+// #define STORE_EACH_LATENCY
+#if (defined STORE_EACH_LATENCY)
+static std::vector<std::vector<uint64_t> > vec_opt_latency; // [thread * TEST_TYPE_COUNT + type]
+#endif
+
+// A timed thread issues every op type it has a count for until it is stopped.
+static inline bool has_next_opt(bool timed, uint64_t count, uint64_t num_opt)
+{
+    return timed ? (num_opt > 0) : (count < num_opt);
+}
+
+// How many keys an op stream visits before it repeats, 0 if that is unbounded.
+static uint64_t key_stream_length(bool timed, uint64_t num_opt, uint64_t key_space)
+{
+    if (num_opt == 0) {
+        return 0;
+    }
+    if (key_space > 0) {
+        return timed ? key_space : std::min(num_opt, key_space);
+    }
+    return timed ? 0 : num_opt;
+}
+
+// Values are filled once per thread, each put only stamps its key into the
+// first bytes so a get can check it read the right record.
+static void fill_value(uint64_t seed, uint8_t* value, size_t length)
+{
+    Random rd(seed);
+    for (size_t i = 0; i < length; i++) {
+        value[i] = 'a' + rd.Uniform(26);
+    }
+}
+
+// Visits up to scan_range records from key. Zero-copy scans only read the
+// first byte of every value slice, which keeps the access from being elided.
+static size_t iterator_scan(KVIterator* it, const char* key, size_t key_length, size_t scan_range, bool zero_copy,
+    std::vector<std::string>* values, uint64_t* bytes, uint64_t* checksum)
+{
+    size_t count = 0;
+    size_t value_length;
+    for (it->Seek(key, key_length); it->Valid() && count < scan_range; it->Next()) {
+        const char* value = it->Value(&value_length);
+        if (zero_copy) {
+            *checksum += (value_length > 0) ? (uint8_t)value[0] : 0;
+        } else {
+            values->push_back(std::string(value, value_length));
+        }
+        *bytes += value_length;
+        count++;
+    }
+    return count;
+}
+
+#if (defined STORE_EACH_LATENCY)
+static void result_output(const char* name, int thread_id, const char* op_name, const std::vector<uint64_t>& data)
+{
+    if (write_latency_file(name, thread_id, op_name, data)) {
+        LOG(INFO) << "|- Detailed results have been output to the file : " << name;
+    }
+}
+#endif
+
+static void* thread_task(void* thread_args)
+{
+    thread_param_t* setup = (struct thread_param_t*)thread_args;
+
+    // bind first, everything the thread allocates below (its own copy of the
+    // entry included) is then local to its node. The main thread wrote setup.
+    if (setup->placement != nullptr) {
+        setup->placement->Bind(setup->test.thread_id);
+    }
+    thread_param_t* param = setup;
+    void* local;
+    if (posix_memalign(&local, CACHE_LINE_SIZE, sizeof(thread_param_t)) == 0) {
+        param = new (local) thread_param_t(*setup);
+    }
+    *setup->local = param;
+
+    bool res;
+    bool seq = param->test.seq;
+    int thread_id = param->test.thread_id;
+    size_t key_length = param->test.key_length;
+    size_t value_length = param->test.value_length;
+
+    KVEngine* db = param->db;
+    param->histogram = new Histogram[TEST_TYPE_COUNT];
+    param->batch_histogram = new Histogram();
+    // counters only follow the thread that opened them.
+    PerfCounters perf;
+    if (param->test.perf_counters) {
+        param->result.perf_error = perf.Open();
+        param->result.perf_mask = perf.Mask();
+        param->result.perf_rdpmc = perf.UsesRdpmc();
+        param->result.perf_user_only = perf.ExcludesKernel();
+    }
+
+    uint64_t num_put_opt = param->test.num_put_opt;
+    uint64_t num_get_opt = param->test.num_get_opt;
+    uint64_t num_delete_opt = param->test.num_delete_opt;
+    uint64_t num_scan_opt = param->test.num_scan_opt;
+    uint64_t num_multiget_opt = param->test.num_multiget_opt;
+    size_t multiget_batch = param->test.multiget_batch;
+
+    uint64_t put_seed = param->test.put_seed;
+    uint64_t get_seed = param->test.get_seed;
+    uint64_t delete_seed = param->test.delete_seed;
+    uint64_t scan_seed = param->test.scan_seed;
+    uint64_t scan_range = param->test.scan_range;
+
+    uint64_t put_sequence_id = param->test.put_sequence_id;
+    uint64_t get_sequence_id = param->test.get_sequence_id;
+    uint64_t delete_sequence_id = param->test.delete_sequence_id;
+    uint64_t scan_sequence_id = param->test.scan_sequence_id;
+    bool timed = param->test.timed;
+    uint64_t key_space = param->test.key_space;
+
+    KeyGenerator put_keys(seq, put_seed, put_sequence_id, 0);
+    KeyGenerator get_keys(seq, get_seed, get_sequence_id, key_space);
+    KeyGenerator delete_keys(seq, delete_seed, delete_sequence_id, key_space);
+    KeyGenerator scan_keys(seq, scan_seed, scan_sequence_id, key_space);
+    KeyGenerator multiget_keys(seq, get_seed, get_sequence_id, key_space);
+
+    uint64_t match_search = 0;
+    uint64_t match_delete = 0;
+    uint64_t match_insert = 0;
+    uint64_t match_scan = 0;
+    uint64_t match_multiget = 0;
+    uint64_t correct_search = 0;
+
+    const char* key;
+    uint8_t value[MAX_VALUE_LENGTH + 10];
+
+    uint64_t num_sum_opt = num_put_opt + num_get_opt + num_delete_opt + num_scan_opt + num_multiget_opt;
+    uint64_t get_count = 0;
+    uint64_t put_count = 0;
+    uint64_t delete_count = 0;
+    uint64_t scan_count = 0;
+    uint64_t multiget_count = 0;
+    uint64_t multiget_key_count = 0;
+    // keys are copied out of the generator, it may reuse its buffer on Next().
+    std::vector<char> multiget_key_buffer(multiget_batch * KEY_STRIDE);
+    std::vector<const char*> multiget_key_ptrs(multiget_batch);
+    std::vector<size_t> multiget_key_lengths(multiget_batch, key_length);
+    std::vector<std::string> multiget_values(multiget_batch);
+    std::unique_ptr<bool[]> multiget_found(new bool[multiget_batch]);
+    uint64_t scan_bytes = 0;
+    uint64_t scan_checksum = 0;
+    uint64_t iterator_count = 0;
+    uint64_t iterator_time = 0;
+    std::vector<std::string> vec_value;
+    bool scan_iterator = param->test.scan_iterator_reuse || param->test.scan_zero_copy;
+    KVIterator* scan_it = nullptr;
+
+    Timer timer;
+    uint64_t opt_latency = 0;
+    uint64_t send_delay = 0;
+    uint64_t sum_count[TEST_TYPE_COUNT] = { 0 };
+    uint64_t sum_latency[TEST_TYPE_COUNT] = { 0 };
+    uint64_t sum_response[TEST_TYPE_COUNT] = { 0 };
+    uint64_t sum_bytes = 0;
+    uint64_t put_bytes = 0;
+    Arrival arrival(param->test.arrival, param->test.target_qps, put_seed ^ ((uint64_t)thread_id << 32));
+
+    // puts/deletes are gathered and only timed as a whole batch, every key of a
+    // batch is then charged an equal share of the WriteBatch latency. Its
+    // response time also counts its send delay and how long it waited in the
+    // buffer before the batch was submitted.
+    bool batching = (param->test.batch_size > 1 || param->test.batch_bytes > 0);
+    BatchBuffer batch(param->test.batch_size, param->test.batch_bytes);
+    std::vector<int> batch_type; // per buffered key, in batch order
+    std::vector<uint64_t> batch_delay; // send delay
+    std::vector<uint64_t> batch_buffered; // when it entered the buffer
+    uint64_t batch_keys = 0;
+    uint64_t batch_time = 0;
+    auto flush_batch = [&]() {
+        size_t num_key = batch.Count();
+        if (num_key == 0) {
+            return;
+        }
+        size_t num_key_type[TEST_TYPE_COUNT] = { 0 };
+        num_key_type[TEST_DELETE] = batch.NumDelete();
+        num_key_type[TEST_PUT] = num_key - num_key_type[TEST_DELETE];
+        size_t bytes = batch.Bytes();
+        uint64_t batch_perf[PERF_NUM_COUNTER] = { 0 };
+
+        uint64_t submit = Arrival::Now();
+        perf.Start();
+        timer.Start();
+        bool status = batch.Write(db);
+        timer.Stop();
+        perf.Stop(batch_perf);
+
+        uint64_t batch_latency = timer.Get();
+        uint64_t key_latency = batch_latency / num_key;
+        param->batch_histogram->Add(batch_latency);
+        batch_keys += num_key;
+        batch_time += batch_latency;
+        for (size_t i = 0; i < num_key; i++) {
+            int t = batch_type[i];
+            uint64_t response = batch_delay[i] + (submit - batch_buffered[i]) + key_latency;
+            sum_response[t] += response;
+            param->histogram[t].Add(response);
+#if (defined STORE_EACH_LATENCY)
+            vec_opt_latency[thread_id * TEST_TYPE_COUNT + t].push_back(response);
+#endif
+        }
+        for (int t = 0; t < TEST_TYPE_COUNT; t++) {
+            if (num_key_type[t] == 0) {
+                continue;
+            }
+            sum_latency[t] += key_latency * num_key_type[t];
+            sum_count[t] += num_key_type[t];
+            for (int c = 0; c < PERF_NUM_COUNTER; c++) {
+                param->result.perf[t][c] += batch_perf[c] * num_key_type[t] / num_key;
+            }
+        }
+        if (status) {
+            match_insert += num_key_type[TEST_PUT];
+            match_delete += num_key_type[TEST_DELETE];
+            sum_bytes += bytes;
+            put_bytes += bytes - num_key_type[TEST_DELETE] * key_length;
+        }
+        batch.Clear();
+        batch_type.clear();
+        batch_delay.clear();
+        batch_buffered.clear();
+    };
+    auto buffer_key = [&](int type, uint64_t delay) {
+        batch_type.push_back(type);
+        batch_delay.push_back(delay);
+        batch_buffered.push_back(Arrival::Now());
+    };
+
+    // everything a thread allocates or formats up front happens before the barrier.
+    const ValueSize* value_size = param->test.value_size;
+    uint64_t value_state = put_seed * 0x9E3779B97F4A7C15ULL + thread_id + 1;
+    std::unique_ptr<ValueGenerator> values;
+    if (num_put_opt > 0 && param->test.compression_ratio > 0) {
+        values.reset(new ValueGenerator(param->test.compression_ratio, put_seed, MAX_VALUE_LENGTH));
+    }
+    fill_value(put_seed, value, (value_size != nullptr) ? value_size->Max() : value_length);
+    if (num_delete_opt > 0) {
+        delete_keys.Skip(param->test.delete_skip);
+    }
+    if (param->test.pregenerate_keys) {
+        put_keys.Pregenerate(key_stream_length(timed, num_put_opt, 0));
+        get_keys.Pregenerate(key_stream_length(timed, num_get_opt, key_space));
+        delete_keys.Pregenerate(key_stream_length(timed, num_delete_opt, key_space));
+        scan_keys.Pregenerate(key_stream_length(timed, num_scan_opt, key_space));
+        multiget_keys.Pregenerate(key_stream_length(timed, num_multiget_opt * multiget_batch, key_space));
+        LOG(INFO) << "|- [PREGENERATE:" << thread_id << "][HUGETLB:" << put_keys.HugePage() << "/" << get_keys.HugePage() << "/" << delete_keys.HugePage() << "/" << scan_keys.HugePage() << "]";
+    }
+    if (num_scan_opt > 0 && scan_iterator) {
+        // probe (and, when reused, keep) the iterator before the phase starts.
+        timer.Start();
+        scan_it = db->NewIterator();
+        timer.Stop();
+        if (scan_it == nullptr) {
+            LOG(INFO) << "|- [" << db->Name() << "] has no iterator, scans fall back to KVEngine::Scan.";
+            scan_iterator = false;
+        } else if (param->test.scan_iterator_reuse) {
+            iterator_count++;
+            iterator_time += timer.Get();
+        } else {
+            delete scan_it;
+            scan_it = nullptr;
+        }
+    }
+    pthread_barrier_wait(param->barrier);
+    param->result.start_ns = Arrival::Now();
+    if (num_sum_opt <= 0) {
+        LOG(INFO) << "|- Thread " << thread_id << " does nothing.";
+        __atomic_add_fetch(param->num_finished, 1, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    LOG(INFO) << "|- [TEST:" << thread_id << "][SEED:" << put_seed << "/" << get_seed << "/" << delete_seed << "][SEQ:" << put_sequence_id << "/" << get_sequence_id << "/" << delete_sequence_id << "]";
+    LOG(INFO) << "|- [PUT:" << num_put_opt << "(" << 100.0 * num_put_opt / num_sum_opt << "%)][GET:num_get_opt"
+              << "(" << 100.0 * num_get_opt / num_sum_opt << "%)][DELETE:" << num_delete_opt << "(" << 100.0 * num_delete_opt / num_sum_opt
+              << "%)][SCAN:" << num_scan_opt << "(" << 100.0 * num_scan_opt / num_sum_opt << "%)][MULTIGET:" << num_multiget_opt << "x" << multiget_batch
+              << "(" << 100.0 * num_multiget_opt / num_sum_opt << "%)]";
+
+    arrival.Start();
+    while (true) {
+        bool flag = false;
+
+        if (__atomic_load_n(param->stop, __ATOMIC_RELAXED)) {
+            break;
+        }
+        if (has_next_opt(timed, put_count, num_put_opt)) {
+            flag = true;
+            put_count++;
+
+            key = put_keys.Next(&res);
+            if (value_size != nullptr) {
+                value_length = value_size->Next(&value_state);
+            }
+            if (values) {
+                memcpy(value, values->Generate(value_length), value_length);
+            }
+            memcpy(value, key, KEY_DIGITS);
+
+            send_delay = arrival.Wait();
+            if (batching) {
+                batch.Add(false, key, key_length, (char*)value, value_length);
+                buffer_key(TEST_PUT, send_delay);
+                if (batch.Full()) {
+                    flush_batch();
+                }
+            } else {
+                perf.Start();
+                timer.Start();
+                bool status = db->Put(key, key_length, (char*)value, value_length);
+                timer.Stop();
+                perf.Stop(param->result.perf[TEST_PUT]);
+
+                opt_latency = timer.Get();
+                sum_latency[TEST_PUT] += opt_latency;
+                sum_response[TEST_PUT] += opt_latency + send_delay;
+                sum_count[TEST_PUT]++;
+                param->histogram[TEST_PUT].Add(opt_latency + send_delay);
+
+#if (defined STORE_EACH_LATENCY)
+                vec_opt_latency[thread_id * TEST_TYPE_COUNT + TEST_PUT].push_back(opt_latency + send_delay);
+#endif
+
+                if (status) {
+                    match_insert++;
+                    sum_bytes += key_length + value_length;
+                    put_bytes += key_length + value_length;
+                }
+            }
+        }
+        if (has_next_opt(timed, get_count, num_get_opt)) {
+            flag = true;
+            get_count++;
+            key = get_keys.Next(&res);
+
+            if (res) {
+                std::string sv;
+                send_delay = arrival.Wait();
+                perf.Start();
+                timer.Start();
+                bool status = db->Get(key, key_length, &sv);
+                timer.Stop();
+                perf.Stop(param->result.perf[TEST_GET]);
+
+                opt_latency = timer.Get();
+                sum_latency[TEST_GET] += opt_latency;
+                sum_response[TEST_GET] += opt_latency + send_delay;
+                sum_count[TEST_GET]++;
+                param->histogram[TEST_GET].Add(opt_latency + send_delay);
+
+#if (defined STORE_EACH_LATENCY)
+                vec_opt_latency[thread_id * TEST_TYPE_COUNT + TEST_GET].push_back(opt_latency + send_delay);
+#endif
+
+                if (status) {
+                    match_search++;
+                    sum_bytes += key_length + sv.size();
+                    if (memcmp(sv.data(), key, key_length) == 0) {
+                        correct_search++;
+                    }
+                }
+            }
+        }
+
+        if (has_next_opt(timed, delete_count, num_delete_opt)) {
+            flag = true;
+            delete_count++;
+            key = delete_keys.Next(&res);
+
+            send_delay = arrival.Wait();
+            if (batching) {
+                batch.Add(true, key, key_length, nullptr, 0);
+                buffer_key(TEST_DELETE, send_delay);
+                if (batch.Full()) {
+                    flush_batch();
+                }
+            } else {
+                perf.Start();
+                timer.Start();
+                bool status = db->Delete(key, key_length);
+                timer.Stop();
+                perf.Stop(param->result.perf[TEST_DELETE]);
+
+                opt_latency = timer.Get();
+                sum_latency[TEST_DELETE] += opt_latency;
+                sum_response[TEST_DELETE] += opt_latency + send_delay;
+                sum_count[TEST_DELETE]++;
+                param->histogram[TEST_DELETE].Add(opt_latency + send_delay);
+
+#if (defined STORE_EACH_LATENCY)
+                vec_opt_latency[thread_id * TEST_TYPE_COUNT + TEST_DELETE].push_back(opt_latency + send_delay);
+#endif
+
+                if (status) {
+                    match_delete++;
+                    sum_bytes += key_length;
+                }
+            }
+        }
+
+        if (has_next_opt(timed, scan_count, num_scan_opt)) {
+            flag = true;
+            scan_count++;
+            key = scan_keys.Next(&res);
+            vec_value.clear();
+            size_t num_scanned;
+            uint64_t bytes = 0;
+
+            send_delay = arrival.Wait();
+            perf.Start();
+            timer.Start();
+            if (!scan_iterator) {
+                num_scanned = db->Scan(key, key_length, scan_range, &vec_value);
+            } else if (scan_it != nullptr) {
+                num_scanned = iterator_scan(scan_it, key, key_length, scan_range, param->test.scan_zero_copy, &vec_value, &bytes, &scan_checksum);
+            } else {
+                Timer create_timer;
+                create_timer.Start();
+                KVIterator* it = db->NewIterator();
+                create_timer.Stop();
+                iterator_count++;
+                iterator_time += create_timer.Get();
+                num_scanned = iterator_scan(it, key, key_length, scan_range, param->test.scan_zero_copy, &vec_value, &bytes, &scan_checksum);
+                delete it;
+            }
+            timer.Stop();
+            perf.Stop(param->result.perf[TEST_SCAN]);
+            if (!scan_iterator) {
+                for (size_t i = 0; i < vec_value.size(); i++) {
+                    bytes += vec_value[i].size();
+                }
+            }
+
+            opt_latency = timer.Get();
+            sum_latency[TEST_SCAN] += opt_latency;
+            sum_response[TEST_SCAN] += opt_latency + send_delay;
+            sum_count[TEST_SCAN]++;
+            param->histogram[TEST_SCAN].Add(opt_latency + send_delay);
+#if (defined STORE_EACH_LATENCY)
+            vec_opt_latency[thread_id * TEST_TYPE_COUNT + TEST_SCAN].push_back(opt_latency + send_delay);
+#endif
+            match_scan += num_scanned;
+            scan_bytes += bytes;
+            sum_bytes += bytes;
+        }
+
+        if (has_next_opt(timed, multiget_count, num_multiget_opt)) {
+            flag = true;
+            multiget_count++;
+            for (size_t i = 0; i < multiget_batch; i++) {
+                char* k = &multiget_key_buffer[i * KEY_STRIDE];
+                memcpy(k, multiget_keys.Next(&res), key_length);
+                multiget_key_ptrs[i] = k;
+            }
+
+            send_delay = arrival.Wait();
+            perf.Start();
+            timer.Start();
+            size_t num_found = db->MultiGet(multiget_key_ptrs.data(), multiget_key_lengths.data(), multiget_batch, multiget_values.data(), multiget_found.get());
+            timer.Stop();
+            perf.Stop(param->result.perf[TEST_MULTIGET]);
+
+            opt_latency = timer.Get();
+            sum_latency[TEST_MULTIGET] += opt_latency;
+            sum_response[TEST_MULTIGET] += opt_latency + send_delay;
+            sum_count[TEST_MULTIGET]++;
+            param->histogram[TEST_MULTIGET].Add(opt_latency + send_delay);
+
+#if (defined STORE_EACH_LATENCY)
+            vec_opt_latency[thread_id * TEST_TYPE_COUNT + TEST_MULTIGET].push_back(opt_latency + send_delay);
+#endif
+
+            multiget_key_count += multiget_batch;
+            match_multiget += num_found;
+            for (size_t i = 0; i < multiget_batch; i++) {
+                if (multiget_found[i]) {
+                    sum_bytes += key_length + multiget_values[i].size();
+                }
+            }
+        }
+
+        if (!flag) {
+            break;
+        }
+    }
+    // a stopped (or finished) thread still writes what it has gathered.
+    flush_batch();
+
+    uint64_t thread_opt_count = 0;
+    uint64_t thread_sum_latency = 0;
+
+    for (int i = 0; i < TEST_TYPE_COUNT; i++) {
+        thread_opt_count += sum_count[i];
+        thread_sum_latency += sum_latency[i];
+    }
+
+    param->result.end_ns = Arrival::Now();
+    __atomic_add_fetch(param->num_finished, 1, __ATOMIC_RELEASE);
+    delete scan_it;
+    param->result.perf_multiplexed = perf.IsOpen() && perf.Multiplexed();
+
+    double exe_time = 1.0 * thread_sum_latency / (1000 * 1000 * 1000);
+    uint64_t thread_avg_latency = (thread_opt_count == 0) ? 0 : thread_sum_latency / thread_opt_count;
+    uint64_t thread_iops = (thread_avg_latency == 0) ? 0 : 1000000000.0 / thread_avg_latency;
+    param->result.iops = thread_iops;
+    param->result.latency = thread_avg_latency;
+    for (int i = 0; i < TEST_TYPE_COUNT; i++) {
+        param->result.count[i] = sum_count[i];
+        param->result.service_time[i] = sum_latency[i];
+        param->result.response_time[i] = sum_response[i];
+    }
+    param->result.bytes = sum_bytes;
+    param->result.put_bytes = put_bytes;
+    param->result.found[TEST_PUT] = match_insert;
+    param->result.found[TEST_GET] = match_search;
+    param->result.found[TEST_DELETE] = match_delete;
+    param->result.found[TEST_SCAN] = match_scan;
+    param->result.found[TEST_MULTIGET] = match_multiget;
+    param->result.multiget_keys = multiget_key_count;
+    param->result.scan_keys = match_scan;
+    param->result.scan_bytes = scan_bytes;
+    param->result.iterator_count = iterator_count;
+    param->result.iterator_time = iterator_time;
+    param->result.batch_keys = batch_keys;
+    param->result.batch_time = batch_time;
+
+    LOG(INFO) << "|- [All:" << thread_opt_count << "][Time:" << exe_time << "seconds][IOPS:" << thread_iops << "][Latency:" << thread_avg_latency << "ns]";
+    if (put_count > 0) {
+        LOG(INFO) << "|- [PUT][Match:" << match_insert << "/" << put_count << "]";
+    }
+    if (get_count > 0) {
+        LOG(INFO) << "|- [GET][Match:" << match_search << "/" << correct_search << "/" << get_count << "]";
+    }
+    if (delete_count > 0) {
+        LOG(INFO) << "|- [DELETE][Match:" << match_delete << "/" << delete_count << "]";
+    }
+    if (multiget_count > 0) {
+        LOG(INFO) << "|- [MULTIGET][Match:" << match_multiget << "/" << multiget_key_count << "][Batch:" << multiget_count << "]";
+    }
+    if (scan_count > 0) {
+        LOG(INFO) << "|- [SCAN][Match:" << match_scan << "/" << scan_count << "][AVG:" << match_scan / scan_count << "]";
+        if (param->test.scan_zero_copy) {
+            LOG(INFO) << "|- [SCAN][Checksum:" << scan_checksum << "]";
+        }
+    }
+    return NULL;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    nanosleep(&ts, NULL);
+}
+
+// IPC and counts per op of every op type, over the threads whose counters opened.
+static void print_perf_counters(const struct thread_param_t* const* params, int num_thread)
+{
+    int num_open = 0;
+    int mask = (1 << PERF_NUM_COUNTER) - 1;
+    bool rdpmc = true;
+    bool user_only = false;
+    bool multiplexed = false;
+    const char* error = nullptr;
+    for (int i = 0; i < num_thread; i++) {
+        const thread_result_t& result = params[i]->result;
+        if (result.perf_mask == 0) {
+            error = (error == nullptr) ? result.perf_error : error;
+            continue;
+        }
+        num_open++;
+        mask &= result.perf_mask;
+        rdpmc = rdpmc && result.perf_rdpmc;
+        user_only = user_only || result.perf_user_only;
+        multiplexed = multiplexed || result.perf_multiplexed;
+    }
+    if (num_open == 0) {
+        LOG(INFO) << "|- [PERF] Counters unavailable: " << ((error != nullptr) ? error : "no counter opened") << ".";
+        return;
+    }
+    LOG(INFO) << "|- [PERF][Threads:" << num_open << "/" << num_thread << "][Read:" << (rdpmc ? "rdpmc" : "read") << "][Scope:" << (user_only ? "user" : "user+kernel") << "]"
+              << (multiplexed ? "[Multiplexed:counts are partial]" : "");
+    for (int j = 0; j < TEST_TYPE_COUNT; j++) {
+        uint64_t count = 0;
+        uint64_t sum[PERF_NUM_COUNTER] = { 0 };
+        for (int i = 0; i < num_thread; i++) {
+            if (params[i]->result.perf_mask == 0) {
+                continue;
+            }
+            count += params[i]->result.count[j];
+            for (int c = 0; c < PERF_NUM_COUNTER; c++) {
+                sum[c] += params[i]->result.perf[j][c];
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        std::string line = std::string("|- [") + test_type_name[j] + "]";
+        char buf[64];
+        if ((mask & (1 << PERF_CYCLES)) && (mask & (1 << PERF_INSTRUCTIONS)) && sum[PERF_CYCLES] > 0) {
+            snprintf(buf, sizeof(buf), "[IPC:%.2f]", 1.0 * sum[PERF_INSTRUCTIONS] / sum[PERF_CYCLES]);
+            line += buf;
+        }
+        for (int c = 0; c < PERF_NUM_COUNTER; c++) {
+            if (mask & (1 << c)) {
+                snprintf(buf, sizeof(buf), "[%s/op:%.2f]", perf_event_defs[c].name, 1.0 * sum[c] / count);
+                line += buf;
+            }
+        }
+        LOG(INFO) << line;
+    }
+}
+
+// Finished threads are noticed within CONTROL_POLL_MS.
+#define CONTROL_POLL_MS (10)
+
+// Runs on the main thread while the workers are busy. Stops them at the phase
+// deadline, or earlier once the windowed throughput of all threads is steady.
+static void control_phase(struct benchmark_param_t* param, Histogram* const* histograms, int num_thread, bool* stop, int* num_finished, uint64_t start_ns)
+{
+    uint64_t deadline = (param->duration > 0) ? start_ns + param->duration * 1000000000 : UINT64_MAX;
+    uint64_t window_ns = param->steady_window_ms * 1000000;
+    uint64_t next_window = (window_ns > 0) ? start_ns + window_ns : UINT64_MAX;
+    uint64_t last_ns = start_ns;
+    uint64_t last_count = 0;
+    SteadyState steady(param->steady_windows, param->steady_cv);
+
+    while (__atomic_load_n(num_finished, __ATOMIC_ACQUIRE) < num_thread) {
+        uint64_t now = Arrival::Now();
+        if (now >= deadline) {
+            LOG(INFO) << "|- [DEADLINE:" << param->duration << "s]";
+            break;
+        }
+        if (now >= next_window) {
+            uint64_t count = 0;
+            for (int i = 0; i < num_thread; i++) {
+                for (int j = 0; j < TEST_TYPE_COUNT; j++) {
+                    count += histograms[i][j].LoadCount();
+                }
+            }
+            double ops_per_sec = 1000000000.0 * (count - last_count) / (now - last_ns);
+            last_count = count;
+            last_ns = now;
+            next_window += window_ns;
+            if (steady.Add(ops_per_sec)) {
+                LOG(INFO) << "|- [STEADY:" << (now - start_ns) / 1000000 << "ms][OPS:" << (uint64_t)ops_per_sec << "/s][CV:" << steady.CV() << "]";
+                break;
+            }
+        }
+        uint64_t wake = now + CONTROL_POLL_MS * 1000000;
+        wake = std::min(wake, std::min(deadline, next_window));
+        sleep_ns(wake - now);
+    }
+    __atomic_store_n(stop, true, __ATOMIC_RELAXED);
+}
+
+MicroBenchmark::MicroBenchmark(struct benchmark_param_t* param, KVEngine* db)
+{
+    this->test_param = param;
+    this->db = db;
+}
+
+void MicroBenchmark::Run()
+{
+    int num_thread = this->test_param->num_thread;
+    std::vector<pthread_t> thread_id(num_thread);
+    // every thread copies its setup entry into one it allocates once it is
+    // bound, and publishes that in thread_params (nullptr until it started).
+    struct thread_param_t* thread_setup;
+    if (posix_memalign((void**)&thread_setup, CACHE_LINE_SIZE, num_thread * sizeof(thread_param_t)) != 0) {
+        LOG(INFO) << "|- Can not allocate " << num_thread << " threads.";
+        return;
+    }
+    memset(thread_setup, 0, num_thread * sizeof(thread_param_t));
+    std::vector<thread_param_t*> thread_params(num_thread, nullptr);
+    uint64_t num_put_opt = this->test_param->num_put_opt;
+    uint64_t num_get_opt = this->test_param->num_get_opt;
+    uint64_t num_delete_opt = this->test_param->num_delete_opt;
+    uint64_t num_scan_opt = this->test_param->num_scan_opt;
+    uint64_t num_multiget_opt = this->test_param->num_multiget_opt;
+
+    LOG(INFO) << "|----------[MicroBenchmark::Run]------------";
+    LOG(INFO) << "|- [PUT:" << num_put_opt << "][GET:" << num_get_opt << "][DELETE:" << num_delete_opt << "][SCAN" << num_scan_opt << "][MULTIGET:" << num_multiget_opt << "]";
+    if (this->test_param->duration > 0) {
+        LOG(INFO) << "|- [DURATION:" << this->test_param->duration << "s]";
+    }
+    if (this->test_param->steady_window_ms > 0) {
+        LOG(INFO) << "|- [STEADY-STATE][WINDOW:" << this->test_param->steady_window_ms << "ms x " << this->test_param->steady_windows << "][CV:" << this->test_param->steady_cv << "]";
+    }
+    if (this->test_param->target_qps > 0) {
+        LOG(INFO) << "|- [OPEN-LOOP][TARGET:" << this->test_param->target_qps << "ops/s][ARRIVAL:" << Arrival::Name(this->test_param->arrival) << "]";
+    }
+    if (num_put_opt > 0 && (this->test_param->value_size != nullptr || this->test_param->compression_ratio > 0)) {
+        LOG(INFO) << "|- [VALUE_SIZE:" << (this->test_param->value_size != nullptr ? this->test_param->value_size->ToString() : "fixed")
+                  << "][COMPRESSION_RATIO:" << this->test_param->compression_ratio << "]";
+    }
+
+    // filled in from thread_params once every thread has allocated its histograms.
+    std::vector<Histogram*> histograms(num_thread, nullptr);
+    bool stop = false;
+    int num_finished = 0;
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_thread + 1);
+
+    // timed threads only need to know which op types to issue.
+    int num_opt_share = (this->test_param->duration > 0) ? 1 : num_thread;
+    for (int i = 0; i < num_thread; i++) {
+        thread_setup[i].db = this->db;
+        thread_setup[i].placement = this->test_param->placement;
+        thread_setup[i].stop = &stop;
+        thread_setup[i].num_finished = &num_finished;
+        thread_setup[i].barrier = &barrier;
+        thread_setup[i].local = &thread_params[i];
+        thread_setup[i].test.seq = this->test_param->seq;
+        thread_setup[i].test.thread_id = i;
+        thread_setup[i].test.key_length = this->test_param->key_length;
+        thread_setup[i].test.value_length = this->test_param->value_length;
+        thread_setup[i].test.num_put_opt = num_put_opt / num_opt_share;
+        thread_setup[i].test.num_get_opt = num_get_opt / num_opt_share;
+        thread_setup[i].test.num_delete_opt = num_delete_opt / num_opt_share;
+        thread_setup[i].test.num_scan_opt = num_scan_opt / num_opt_share;
+        thread_setup[i].test.num_multiget_opt = num_multiget_opt / num_opt_share;
+        thread_setup[i].test.multiget_batch = this->test_param->multiget_batch;
+        thread_setup[i].test.put_seed = this->test_param->put_seed[i];
+        thread_setup[i].test.get_seed = this->test_param->get_seed[i];
+        thread_setup[i].test.delete_seed = this->test_param->delete_seed[i];
+        thread_setup[i].test.scan_seed = this->test_param->scan_seed[i];
+        thread_setup[i].test.put_sequence_id = this->test_param->put_sequence_id[i];
+        thread_setup[i].test.get_sequence_id = this->test_param->get_sequence_id[i];
+        thread_setup[i].test.delete_sequence_id = this->test_param->delete_sequence_id[i];
+        thread_setup[i].test.scan_sequence_id = this->test_param->scan_sequence_id[i];
+        thread_setup[i].test.scan_range = this->test_param->scan_range;
+        thread_setup[i].test.scan_iterator_reuse = this->test_param->scan_iterator_reuse;
+        thread_setup[i].test.scan_zero_copy = this->test_param->scan_zero_copy;
+        thread_setup[i].test.batch_size = this->test_param->batch_size;
+        thread_setup[i].test.batch_bytes = this->test_param->batch_bytes;
+        thread_setup[i].test.target_qps = 1.0 * this->test_param->target_qps / num_thread;
+        thread_setup[i].test.arrival = this->test_param->arrival;
+        thread_setup[i].test.timed = (this->test_param->duration > 0);
+        thread_setup[i].test.key_space = this->test_param->key_space[i];
+        thread_setup[i].test.delete_skip = this->test_param->delete_skip;
+        thread_setup[i].test.pregenerate_keys = this->test_param->pregenerate_keys;
+        thread_setup[i].test.value_size = this->test_param->value_size;
+        thread_setup[i].test.compression_ratio = this->test_param->compression_ratio;
+        thread_setup[i].test.perf_counters = this->test_param->perf_counters;
+    }
+
+#if (defined STORE_EACH_LATENCY)
+    vec_opt_latency.resize(num_thread * TEST_TYPE_COUNT);
+#endif
+    Reporter reporter(this->test_param->report_file, this->test_param->report_format, this->test_param->report_interval_ms,
+        histograms.data(), num_thread, TEST_TYPE_COUNT, test_type_name);
+
+    for (int i = 0; i < num_thread; i++) {
+        pthread_create(&thread_id[i], NULL, thread_task, (void*)&thread_setup[i]);
+    }
+    // the phase is timed on the wall clock from the moment every thread is ready.
+    pthread_barrier_wait(&barrier);
+    uint64_t start_ns = Arrival::Now();
+    for (int i = 0; i < num_thread; i++) {
+        histograms[i] = thread_params[i]->histogram;
+    }
+    if (this->test_param->placement != nullptr && this->test_param->placement->Policy() != PLACEMENT_NONE) {
+        for (int i = 0; i < num_thread; i++) {
+            LOG(INFO) << "|- [Thread:" << i << "][" << this->test_param->placement->ToString(i) << "]";
+        }
+    }
+    if (reporter.Start()) {
+        LOG(INFO) << "|- [TIMELINE:" << this->test_param->report_file << "][INTERVAL:" << this->test_param->report_interval_ms << "ms]";
+    }
+    if (this->test_param->duration > 0 || this->test_param->steady_window_ms > 0) {
+        control_phase(this->test_param, histograms.data(), num_thread, &stop, &num_finished, start_ns);
+    }
+
+    for (int i = 0; i < num_thread; i++) {
+        pthread_join(thread_id[i], NULL);
+        this->test_param->num_put_done[i] = thread_params[i]->result.count[TEST_PUT];
+    }
+    reporter.Stop();
+    pthread_barrier_destroy(&barrier);
+
+    // a thread may run (or even finish) before the main thread reads the clock
+    // after the barrier, so the phase starts with the earliest thread.
+    uint64_t phase_start_ns = start_ns;
+    uint64_t end_ns = start_ns;
+    for (int i = 0; i < num_thread; i++) {
+        phase_start_ns = std::min(phase_start_ns, thread_params[i]->result.start_ns);
+    }
+    uint64_t total_opt = 0;
+    uint64_t total_bytes = 0;
+    uint64_t total_service_time = 0;
+
+    for (int i = 0; i < num_thread; i++) {
+        uint64_t thread_opt = 0;
+        for (int j = 0; j < TEST_TYPE_COUNT; j++) {
+            thread_opt += thread_params[i]->result.count[j];
+            total_service_time += thread_params[i]->result.service_time[j];
+        }
+        if (thread_opt == 0) {
+            continue;
+        }
+        uint64_t thread_end_ns = thread_params[i]->result.end_ns;
+        double thread_time = (thread_end_ns - thread_params[i]->result.start_ns) / 1000000000.0;
+        LOG(INFO) << "|- [Thread:" << i << "][Count:" << thread_opt << "][Wall:" << thread_time << "seconds][IOPS:" << (uint64_t)(thread_opt / thread_time) << "]";
+        end_ns = std::max(end_ns, thread_end_ns);
+        total_opt += thread_opt;
+        total_bytes += thread_params[i]->result.bytes;
+    }
+
+    // aggregate rates divide by the phase's wall time, not each thread's own busy time.
+    double wall_time = (end_ns - phase_start_ns) / 1000000000.0;
+    uint64_t total_iops = (wall_time > 0) ? total_opt / wall_time : 0;
+    double total_bw = (wall_time > 0) ? total_bytes / (1024.0 * 1024 * wall_time) : 0;
+    uint64_t avg_latency = (total_opt == 0) ? 0 : total_service_time / total_opt;
+
+    LOG(INFO) << "|- [Count:" << total_opt << "][Wall:" << wall_time << "seconds][IOPS:" << total_iops << "][BW:" << total_bw << "MB/s][Latency:" << avg_latency << "ns]";
+    if (this->test_param->perf_counters) {
+        print_perf_counters(thread_params.data(), num_thread);
+    }
+    this->test_param->put_bytes = 0;
+    for (int i = 0; i < num_thread; i++) {
+        this->test_param->put_bytes += thread_params[i]->result.put_bytes;
+    }
+    this->test_param->latency.assign(TEST_TYPE_COUNT, Histogram());
+    for (int j = 0; j < TEST_TYPE_COUNT; j++) {
+        Histogram& merged = this->test_param->latency[j];
+        this->test_param->num_found[j] = 0;
+        for (int i = 0; i < num_thread; i++) {
+            merged.Merge(thread_params[i]->histogram[j]);
+            this->test_param->num_found[j] += thread_params[i]->result.found[j];
+        }
+        if (merged.Count() > 0) {
+            LOG(INFO) << "|- [" << test_type_name[j] << "]" << merged.ToString();
+        }
+    }
+    if (this->test_param->latency[TEST_SCAN].Count() > 0) {
+        uint64_t scan_keys = 0;
+        uint64_t scan_bytes = 0;
+        uint64_t scan_time = 0;
+        uint64_t iterator_count = 0;
+        uint64_t iterator_time = 0;
+        for (int i = 0; i < num_thread; i++) {
+            scan_keys += thread_params[i]->result.scan_keys;
+            scan_bytes += thread_params[i]->result.scan_bytes;
+            scan_time += thread_params[i]->result.service_time[TEST_SCAN];
+            iterator_count += thread_params[i]->result.iterator_count;
+            iterator_time += thread_params[i]->result.iterator_time;
+        }
+        uint64_t num_scan = this->test_param->latency[TEST_SCAN].Count();
+        const char* mode = this->test_param->scan_iterator_reuse ? "iterator-reuse" : (this->test_param->scan_zero_copy ? "iterator" : "copy");
+        LOG(INFO) << "|- [SCAN][Mode:" << mode << (this->test_param->scan_zero_copy ? "+zero-copy" : "") << "][Keys:" << scan_keys << "][Keys/Scan:" << scan_keys / num_scan
+                  << "][Bytes:" << scan_bytes / (1024.0 * 1024) << "MB][PerKey:" << ((scan_keys == 0) ? 0 : scan_time / scan_keys) << "ns]";
+        if (iterator_count > 0) {
+            LOG(INFO) << "|- [SCAN][NewIterator:" << iterator_count << "][Avg:" << iterator_time / iterator_count << "ns]";
+        }
+    }
+    if (this->test_param->latency[TEST_MULTIGET].Count() > 0) {
+        uint64_t multiget_keys = 0;
+        uint64_t multiget_time = 0;
+        for (int i = 0; i < num_thread; i++) {
+            multiget_keys += thread_params[i]->result.multiget_keys;
+            multiget_time += thread_params[i]->result.service_time[TEST_MULTIGET];
+        }
+        uint64_t keys_per_sec = (wall_time > 0) ? multiget_keys / wall_time : 0;
+        LOG(INFO) << "|- [MULTIGET][Batch:" << this->test_param->multiget_batch << "][Keys:" << multiget_keys << "][Found:" << this->test_param->num_found[TEST_MULTIGET]
+                  << "][Keys/s:" << keys_per_sec << "][PerKey:" << multiget_time / multiget_keys << "ns]";
+    }
+    Histogram batch_latency;
+    uint64_t batch_keys = 0;
+    uint64_t batch_time = 0;
+    for (int i = 0; i < num_thread; i++) {
+        batch_latency.Merge(*thread_params[i]->batch_histogram);
+        batch_keys += thread_params[i]->result.batch_keys;
+        batch_time += thread_params[i]->result.batch_time;
+    }
+    if (batch_latency.Count() > 0) {
+        LOG(INFO) << "|- [BATCH][Size:" << this->test_param->batch_size << "][Bytes:" << this->test_param->batch_bytes << "][Keys/Batch:" << batch_keys / batch_latency.Count()
+                  << "][PerKey:" << batch_time / batch_keys << "ns]";
+        LOG(INFO) << "|- [BATCH]" << batch_latency.ToString();
+    }
+    for (int i = 0; i < num_thread; i++) {
+        delete[] thread_params[i]->histogram;
+        delete thread_params[i]->batch_histogram;
+    }
+    if (this->test_param->target_qps > 0) {
+        for (int j = 0; j < TEST_TYPE_COUNT; j++) {
+            uint64_t count = 0;
+            uint64_t service_time = 0;
+            uint64_t response_time = 0;
+            for (int i = 0; i < num_thread; i++) {
+                count += thread_params[i]->result.count[j];
+                service_time += thread_params[i]->result.service_time[j];
+                response_time += thread_params[i]->result.response_time[j];
+            }
+            if (count > 0) {
+                LOG(INFO) << "|- [" << test_type_name[j] << "][Count:" << count << "][Service:" << service_time / count << "ns][Response:" << response_time / count << "ns]";
+            }
+        }
+    }
+#if (defined STORE_EACH_LATENCY)
+    char dname[128];
+    snprintf(dname, sizeof(dname), "%s_detail_%zu", this->db->Name(), this->test_param->value_length);
+    mkdir(dname, 0777);
+    for (int i = 0; i < num_thread; i++) {
+        for (int j = 0; j < TEST_TYPE_COUNT; j++) {
+            if (vec_opt_latency[i * TEST_TYPE_COUNT + j].size() > 0) {
+                char name[128];
+                snprintf(name, sizeof(name), "%s/%d_%d." LATENCY_EXTENSION, dname, i, j);
+                result_output(name, i, test_type_name[j], vec_opt_latency[i * TEST_TYPE_COUNT + j]);
+                vec_opt_latency[i * TEST_TYPE_COUNT + j].clear();
+            }
+        }
+    }
+#endif
+    for (int i = 0; i < num_thread; i++) {
+        if (thread_params[i] != &thread_setup[i]) {
+            free(thread_params[i]);
+        }
+    }
+    free(thread_setup);
+    LOG(INFO) << "|-------------------------------------------";
+}
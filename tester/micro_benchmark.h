@@ -0,0 +1,153 @@
+#ifndef INCLUDE_MICRO_BENCHMARK_H_
+#define INCLUDE_MICRO_BENCHMARK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "arrival.h"
+#include "config.h"
+#include "histogram.h"
+#include "kv_engine.h"
+#include "reporter.h"
+#include "thread_placement.h"
+#include "value_generator.h"
+
+#define TEST_TYPE_COUNT (5)
+#define TEST_PUT (0)
+#define TEST_GET (1)
+#define TEST_DELETE (2)
+#define TEST_SCAN (3)
+#define TEST_MULTIGET (4) // one op is a batch of multiget_batch lookups
+
+struct benchmark_param_t
+{
+public:
+  bool seq;
+  int num_thread;
+  size_t key_length;
+  size_t value_length;
+  uint64_t num_get_opt;
+  uint64_t num_put_opt;
+  uint64_t num_delete_opt;
+  uint64_t num_scan_opt;
+  uint64_t num_multiget_opt; // batches, their keys follow the get key stream
+  size_t multiget_batch;
+  // per-thread, sized by SetNumThread()
+  std::vector<uint64_t> put_seed;
+  std::vector<uint64_t> get_seed;
+  std::vector<uint64_t> delete_seed;
+  std::vector<uint64_t> scan_seed;
+  std::vector<uint64_t> put_sequence_id;
+  std::vector<uint64_t> get_sequence_id;
+  std::vector<uint64_t> delete_sequence_id;
+  std::vector<uint64_t> scan_sequence_id;
+  uint64_t scan_range;
+  // Scans go through one KVIterator per scan (or per thread with
+  // scan_iterator_reuse, re-Seek per scan) instead of KVEngine::Scan, and
+  // scan_zero_copy only reads the value slices instead of copying them out.
+  bool scan_iterator_reuse;
+  bool scan_zero_copy;
+  // puts/deletes are written through KVEngine::WriteBatch once a thread has
+  // gathered batch_size of them or batch_bytes of keys and values (0 disables
+  // either limit, batch_size <= 1 and batch_bytes 0 write every key alone).
+  size_t batch_size;
+  size_t batch_bytes;
+  uint64_t target_qps; // 0 is closed-loop
+  int arrival;
+  uint64_t report_interval_ms; // 0 disables the timeline
+  int report_format;
+  char report_file[256];
+  // Every thread runs its op mix until a shared deadline instead of the op
+  // counts, which then only say which op types are issued (0 runs the counts).
+  uint64_t duration; // seconds
+  uint64_t steady_window_ms; // 0 disables steady-state detection
+  int steady_windows; // windows in the stability check
+  double steady_cv; // stop once their ops/s stddev / mean <= steady_cv
+  // get/scan/delete rewind to their first key after key_space[i] ops, so a phase
+  // only reads what an early-stopped warmup actually wrote (0 never rewinds).
+  std::vector<uint64_t> key_space;
+  uint64_t delete_skip; // keys every thread's delete stream skips before its first delete
+  // filled in by MicroBenchmark::Run
+  std::vector<uint64_t> num_put_done;
+  uint64_t num_found[TEST_TYPE_COUNT]; // puts/deletes that succeeded, gets (and multiget keys) that found their key, records scanned
+  uint64_t put_bytes; // key and value bytes of the puts that succeeded
+  std::vector<Histogram> latency; // [TEST_TYPE_COUNT], merged over all threads
+  bool pregenerate_keys; // format every key before the phase starts
+  const ThreadPlacement* placement; // nullptr leaves threads unbound
+  // Every put draws its value length from value_size (nullptr writes
+  // value_length bytes). With compression_ratio in (0, 1] its bytes are cut
+  // from a ValueGenerator pool that compresses to about that ratio, 0 keeps
+  // one letter-filled value per thread.
+  const ValueSize* value_size;
+  double compression_ratio;
+  // every thread counts cycles, instructions, LLC/dTLB/branch misses around
+  // its timed ops (perf_counter.h) and Run prints IPC and misses per op.
+  bool perf_counters;
+
+public:
+  benchmark_param_t()
+  {
+    seq = false;
+    key_length = 16;
+    value_length = 1024;
+    num_get_opt = num_put_opt = num_delete_opt = num_scan_opt = 0;
+    num_multiget_opt = 0;
+    multiget_batch = 16;
+    SetNumThread(1);
+    scan_range = 1000;
+    scan_iterator_reuse = false;
+    scan_zero_copy = false;
+    batch_size = 0;
+    batch_bytes = 0;
+    target_qps = 0;
+    arrival = ARRIVAL_CLOSED;
+    report_interval_ms = 0;
+    report_format = REPORT_CSV;
+    report_file[0] = '\0';
+    duration = 0;
+    steady_window_ms = 0;
+    steady_windows = 5;
+    steady_cv = 0.05;
+    pregenerate_keys = false;
+    placement = nullptr;
+    value_size = nullptr;
+    compression_ratio = 0;
+    perf_counters = false;
+    delete_skip = 0;
+    put_bytes = 0;
+    memset(num_found, 0, sizeof(num_found));
+  }
+
+  void SetNumThread(int n)
+  {
+    num_thread = n;
+    put_seed.assign(n, 0);
+    get_seed.assign(n, 0);
+    delete_seed.assign(n, 0);
+    scan_seed.assign(n, 0);
+    put_sequence_id.assign(n, 0);
+    get_sequence_id.assign(n, 0);
+    delete_sequence_id.assign(n, 0);
+    scan_sequence_id.assign(n, 0);
+    key_space.assign(n, 0);
+    num_put_done.assign(n, 0);
+  }
+};
+
+class MicroBenchmark
+{
+public:
+  MicroBenchmark(struct benchmark_param_t *param, KVEngine *db);
+  void Run();
+  void Print();
+
+private:
+  struct benchmark_param_t *test_param;
+  KVEngine *db;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,296 @@
+#ifndef INCLUDE_PERF_COUNTER_H_
+#define INCLUDE_PERF_COUNTER_H_
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_CYCLES (0)
+#define PERF_INSTRUCTIONS (1)
+#define PERF_LLC_MISSES (2)
+#define PERF_DTLB_MISSES (3)
+#define PERF_BRANCH_MISSES (4)
+#define PERF_NUM_COUNTER (5)
+
+struct perf_event_def_t {
+    uint32_t type;
+    uint64_t config;
+    const char* name;
+};
+
+// the generic cache-misses event is the last level cache on x86.
+static const perf_event_def_t perf_event_defs[PERF_NUM_COUNTER] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "Cycles" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "Instructions" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "LLC-miss" },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), "dTLB-miss" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "Branch-miss" },
+};
+
+// One counter group (perf_event_defs) of the calling thread. Start()/Stop()
+// bracket a region and return what it counted, read with rdpmc from user space
+// when the kernel allows it, else with one read() of the whole group. Counters
+// the CPU (or the hypervisor) does not have are left out, and a thread whose
+// group can not be opened at all just gets zero deltas. Not thread safe, every
+// thread opens its own.
+class PerfCounters {
+public:
+    PerfCounters()
+        : leader(-1)
+        , num_open(0)
+        , rdpmc(false)
+        , exclude_kernel(false)
+    {
+        for (int i = 0; i < PERF_NUM_COUNTER; i++) {
+            fd[i] = -1;
+            slot[i] = -1;
+            page[i] = nullptr;
+            begin[i] = 0;
+        }
+    }
+
+    ~PerfCounters()
+    {
+        Close();
+    }
+
+    // Opens and enables the group, nullptr on success, else why the counters
+    // are unavailable. Kernel time is counted too unless perf_event_paranoid
+    // forbids it.
+    const char* Open(void)
+    {
+        int error = OpenGroup(false);
+        if (error == EACCES || error == EPERM) {
+            Close();
+            error = OpenGroup(true);
+        }
+        if (error != 0) {
+            Close();
+            return Reason(error);
+        }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return nullptr;
+    }
+
+    bool IsOpen(void) const
+    {
+        return leader >= 0;
+    }
+
+    // bit i set when perf_event_defs[i] is counted.
+    int Mask(void) const
+    {
+        int mask = 0;
+        for (int i = 0; i < PERF_NUM_COUNTER; i++) {
+            mask |= (fd[i] >= 0) ? (1 << i) : 0;
+        }
+        return mask;
+    }
+
+    bool UsesRdpmc(void) const
+    {
+        return rdpmc;
+    }
+
+    bool ExcludesKernel(void) const
+    {
+        return exclude_kernel;
+    }
+
+    void Start(void)
+    {
+        if (leader >= 0) {
+            Read(begin);
+        }
+    }
+
+    // Adds what was counted since Start() to delta[PERF_NUM_COUNTER].
+    void Stop(uint64_t* delta)
+    {
+        if (leader < 0) {
+            return;
+        }
+        uint64_t end[PERF_NUM_COUNTER];
+        Read(end);
+        for (int i = 0; i < PERF_NUM_COUNTER; i++) {
+            delta[i] += end[i] - begin[i];
+        }
+    }
+
+    // True once the kernel had to time-share the group with other events, the
+    // counts then only cover part of the run.
+    bool Multiplexed(void) const
+    {
+        uint64_t enabled, running;
+        uint64_t values[PERF_NUM_COUNTER];
+        return ReadGroup(values, &enabled, &running) && running < enabled;
+    }
+
+    void Close(void)
+    {
+        for (int i = 0; i < PERF_NUM_COUNTER; i++) {
+            if (page[i] != nullptr) {
+                munmap((void*)page[i], PageSize());
+                page[i] = nullptr;
+            }
+            if (fd[i] >= 0) {
+                close(fd[i]);
+                fd[i] = -1;
+            }
+            slot[i] = -1;
+        }
+        leader = -1;
+        num_open = 0;
+        rdpmc = false;
+    }
+
+private:
+    static size_t PageSize(void)
+    {
+        return (size_t)sysconf(_SC_PAGESIZE);
+    }
+
+    // 0, or the errno that kept the first counter from opening.
+    int OpenGroup(bool no_kernel)
+    {
+        int first_error = 0;
+        exclude_kernel = no_kernel;
+        rdpmc = true;
+        for (int i = 0; i < PERF_NUM_COUNTER; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = perf_event_defs[i].type;
+            attr.config = perf_event_defs[i].config;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = (leader < 0); // the group starts once it is complete
+            attr.exclude_kernel = no_kernel;
+            attr.exclude_hv = 1;
+            fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+            if (fd[i] < 0) {
+                first_error = (first_error == 0) ? errno : first_error;
+                continue;
+            }
+            if (leader < 0) {
+                leader = fd[i];
+            }
+            slot[i] = num_open++;
+            // the mapped page tells rdpmc which hardware counter holds the event.
+            void* addr = mmap(nullptr, PageSize(), PROT_READ, MAP_SHARED, fd[i], 0);
+            if (addr == MAP_FAILED) {
+                rdpmc = false;
+            } else {
+                page[i] = (const struct perf_event_mmap_page*)addr;
+                rdpmc = rdpmc && page[i]->cap_user_rdpmc;
+            }
+        }
+        return (leader < 0) ? first_error : 0;
+    }
+
+    static const char* Reason(int error)
+    {
+        switch (error) {
+        case EACCES:
+        case EPERM:
+            return "not permitted, see kernel.perf_event_paranoid";
+        case ENOENT:
+        case ENODEV:
+        case EOPNOTSUPP:
+            return "no hardware counters on this CPU (virtualised?)";
+        case ENOSYS:
+            return "no perf_event_open in this kernel";
+        case EMFILE:
+            return "out of file descriptors";
+        default:
+            return "perf_event_open failed";
+        }
+    }
+
+    void Read(uint64_t* values)
+    {
+        if (rdpmc) {
+            int i = 0;
+            while (i < PERF_NUM_COUNTER && (fd[i] < 0 || ReadPmc(page[i], &values[i]))) {
+                values[i] = (fd[i] < 0) ? 0 : values[i];
+                i++;
+            }
+            if (i == PERF_NUM_COUNTER) {
+                return;
+            }
+        }
+        // a counter that is not on the CPU right now is only readable by the kernel.
+        uint64_t enabled, running;
+        if (!ReadGroup(values, &enabled, &running)) {
+            memset(values, 0, PERF_NUM_COUNTER * sizeof(uint64_t));
+        }
+    }
+
+    bool ReadGroup(uint64_t* values, uint64_t* enabled, uint64_t* running) const
+    {
+        // nr, time_enabled, time_running, then one value per open counter.
+        uint64_t buf[3 + PERF_NUM_COUNTER];
+        ssize_t n = read(leader, buf, sizeof(buf));
+        if (n < (ssize_t)(3 * sizeof(uint64_t)) || buf[0] != (uint64_t)num_open) {
+            return false;
+        }
+        *enabled = buf[1];
+        *running = buf[2];
+        for (int i = 0; i < PERF_NUM_COUNTER; i++) {
+            values[i] = (slot[i] < 0) ? 0 : buf[3 + slot[i]];
+        }
+        return true;
+    }
+
+    // The self-monitoring sequence of perf_event.h, false if the event is not
+    // on a hardware counter (index 0) and has to be read by the kernel.
+    static bool ReadPmc(const struct perf_event_mmap_page* pc, uint64_t* value)
+    {
+#if (defined __x86_64__ || defined __i386__)
+        const volatile struct perf_event_mmap_page* p = pc;
+        uint32_t seq;
+        uint64_t count;
+        do {
+            seq = p->lock;
+            __asm__ __volatile__("" ::: "memory");
+            uint32_t index = p->index;
+            if (index == 0 || !p->cap_user_rdpmc) {
+                return false;
+            }
+            uint32_t lo, hi;
+            __asm__ __volatile__("rdpmc"
+                                 : "=a"(lo), "=d"(hi)
+                                 : "c"(index - 1));
+            // the hardware counter is pmc_width bits wide, offset carries the rest.
+            int shift = 64 - p->pmc_width;
+            int64_t pmc = (int64_t)((((uint64_t)hi) << 32) | lo);
+            pmc = (int64_t)((uint64_t)pmc << shift) >> shift;
+            count = p->offset + pmc;
+            __asm__ __volatile__("" ::: "memory");
+        } while (p->lock != seq);
+        *value = count;
+        return true;
+#else
+        (void)pc;
+        (void)value;
+        return false;
+#endif
+    }
+
+private:
+    int fd[PERF_NUM_COUNTER];
+    int slot[PERF_NUM_COUNTER]; // position in the group read, -1 if not open
+    const struct perf_event_mmap_page* page[PERF_NUM_COUNTER];
+    uint64_t begin[PERF_NUM_COUNTER];
+    int leader;
+    int num_open;
+    bool rdpmc;
+    bool exclude_kernel;
+};
+
+#endif
@@ -0,0 +1,387 @@
+#ifndef INCLUDE_PMEM_EMULATOR_H_
+#define INCLUDE_PMEM_EMULATOR_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "kv_engine.h"
+#include "timer.h"
+
+#define PMEM_CACHELINE (64)
+// What an NVM memtable stores next to a record's key and value (sequence,
+// type, lengths), flushed with it.
+#define PMEM_RECORD_HEADER (16)
+
+// The persistent memory a DRAM-backed run pretends to have. Latencies are
+// charged on top of what the DRAM access itself took, bandwidths of 0 leave
+// that direction uncapped.
+struct pmem_emulation_t {
+public:
+    char dir[128]; // tmpfs or hugetlbfs mount the nvm path is moved to, empty is off
+    uint64_t read_latency_ns; // per access, the lines after the first stream in
+    uint64_t write_latency_ns; // per flushed cacheline
+    uint64_t read_bandwidth_mb; // MB/s
+    uint64_t write_bandwidth_mb;
+
+public:
+    pmem_emulation_t()
+        : read_latency_ns(200)
+        , write_latency_ns(100)
+        , read_bandwidth_mb(6000)
+        , write_bandwidth_mb(2000)
+    {
+        dir[0] = '\0';
+    }
+};
+
+// One direction of the emulated device, shared by every thread. A transfer
+// books the device for bytes / bandwidth after the previous one, so threads
+// that go faster than the cap queue up behind each other.
+class PmemChannel {
+public:
+    explicit PmemChannel(uint64_t bandwidth_mb)
+        : ns_per_byte((bandwidth_mb == 0) ? 0 : 1e9 / (bandwidth_mb * 1048576.0))
+        , busy_until(0)
+    {
+    }
+
+    // When a transfer of bytes starting at now is through.
+    uint64_t Reserve(uint64_t now, uint64_t bytes)
+    {
+        if (ns_per_byte == 0) {
+            return now;
+        }
+        uint64_t cost = (uint64_t)(bytes * ns_per_byte);
+        uint64_t busy = busy_until.load(std::memory_order_relaxed);
+        uint64_t done;
+        do {
+            done = ((busy > now) ? busy : now) + cost;
+        } while (!busy_until.compare_exchange_weak(busy, done, std::memory_order_relaxed));
+        return done;
+    }
+
+private:
+    double ns_per_byte;
+    std::atomic<uint64_t> busy_until;
+};
+
+// Cost model of the emulated device, Write()/Read() spin until the transfer
+// would have finished on it.
+class PmemDevice {
+public:
+    explicit PmemDevice(const pmem_emulation_t& config)
+        : config(config)
+        , read_channel(config.read_bandwidth_mb)
+        , write_channel(config.write_bandwidth_mb)
+        , lines_written(0)
+        , lines_read(0)
+        , write_delay_ns(0)
+        , read_delay_ns(0)
+    {
+    }
+
+    // Flushes (clwb, then a fence) lines cachelines.
+    void Write(uint64_t lines)
+    {
+        const TscClock& clock = TscClock::Get();
+        uint64_t now = clock.Now();
+        uint64_t done = now + lines * config.write_latency_ns;
+        uint64_t drained = write_channel.Reserve(now, lines * PMEM_CACHELINE);
+        done = (drained > done) ? drained : done;
+        SpinUntil(clock, done);
+        lines_written.fetch_add(lines, std::memory_order_relaxed);
+        write_delay_ns.fetch_add(done - now, std::memory_order_relaxed);
+    }
+
+    // accesses random reads of lines cachelines in all.
+    void Read(uint64_t accesses, uint64_t lines)
+    {
+        const TscClock& clock = TscClock::Get();
+        uint64_t now = clock.Now();
+        uint64_t done = now + accesses * config.read_latency_ns;
+        uint64_t drained = read_channel.Reserve(now, lines * PMEM_CACHELINE);
+        done = (drained > done) ? drained : done;
+        SpinUntil(clock, done);
+        lines_read.fetch_add(lines, std::memory_order_relaxed);
+        read_delay_ns.fetch_add(done - now, std::memory_order_relaxed);
+    }
+
+    // [Flushed:120.5MB][Read:300.2MB][WriteDelay:1520.3ms][ReadDelay:610.0ms]
+    std::string ToString(void) const
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "[Flushed:%.1fMB][Read:%.1fMB][WriteDelay:%.1fms][ReadDelay:%.1fms]",
+            lines_written.load() * PMEM_CACHELINE / 1048576.0, lines_read.load() * PMEM_CACHELINE / 1048576.0,
+            write_delay_ns.load() / 1000000.0, read_delay_ns.load() / 1000000.0);
+        return buf;
+    }
+
+    static uint64_t Lines(uint64_t bytes)
+    {
+        return (bytes + PMEM_CACHELINE - 1) / PMEM_CACHELINE;
+    }
+
+private:
+    static void SpinUntil(const TscClock& clock, uint64_t deadline)
+    {
+        while (clock.Now() < deadline) {
+#if (defined __x86_64__ || defined __i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+    }
+
+private:
+    pmem_emulation_t config;
+    PmemChannel read_channel;
+    PmemChannel write_channel;
+    std::atomic<uint64_t> lines_written;
+    std::atomic<uint64_t> lines_read;
+    std::atomic<uint64_t> write_delay_ns;
+    std::atomic<uint64_t> read_delay_ns;
+};
+
+// Charges the device for the records an iterator visits, a Seek() is a random
+// access and the Next()s after it stream.
+class PmemIterator : public KVIterator {
+public:
+    PmemIterator(KVIterator* it, PmemDevice* device)
+        : it(it)
+        , device(device)
+    {
+    }
+
+    ~PmemIterator()
+    {
+        delete it;
+    }
+
+    void Seek(const char* key, size_t key_length)
+    {
+        it->Seek(key, key_length);
+        device->Read(1, PmemDevice::Lines(key_length + PMEM_RECORD_HEADER + ValueLength()));
+    }
+
+    bool Valid()
+    {
+        return it->Valid();
+    }
+
+    void Next()
+    {
+        it->Next();
+        device->Read(0, PmemDevice::Lines(ValueLength()));
+    }
+
+    const char* Value(size_t* value_length)
+    {
+        return it->Value(value_length);
+    }
+
+private:
+    size_t ValueLength(void)
+    {
+        size_t value_length = 0;
+        if (it->Valid()) {
+            it->Value(&value_length);
+        }
+        return value_length;
+    }
+
+private:
+    KVIterator* it;
+    PmemDevice* device;
+};
+
+// Lets the NVM-based engines (NoveLSM, SLM-DB) run without an Optane mount.
+// Place() moves their nvm path onto a tmpfs or hugetlbfs mount, where the
+// files they map are plain DRAM, and the wrapper charges every request for
+// the NVM traffic it causes: a put flushes its record, a get or scan reads
+// the records it returns. The engines flush inside their own libraries, so
+// the cost is modelled at the adapter boundary rather than per real clwb,
+// what they move between NVM and SSTables in the background is not charged.
+class PmemEmulator : public KVEngine {
+public:
+    // Takes ownership of target.
+    PmemEmulator(KVEngine* target, const pmem_emulation_t& config)
+        : target(target)
+        , device(config)
+    {
+    }
+
+    ~PmemEmulator()
+    {
+        delete target;
+    }
+
+    // Writes dir/<last component of nvm_path> to out, false with *error set
+    // if dir is not a DRAM filesystem or a shared mapping of a file on it
+    // fails (e.g. no free huge pages). *fs_name is "tmpfs" or "hugetlbfs".
+    static bool Place(const char* dir, const char* nvm_path, char* out, size_t out_size, const char** fs_name, std::string* error)
+    {
+        struct statfs fs;
+        if (statfs(dir, &fs) != 0) {
+            *error = std::string("can not stat [") + dir + "]: " + strerror(errno);
+            return false;
+        }
+        if (fs.f_type == TMPFS_MAGIC) {
+            *fs_name = "tmpfs";
+        } else if (fs.f_type == HUGETLBFS_MAGIC) {
+            *fs_name = "hugetlbfs";
+        } else {
+            *error = std::string("[") + dir + "] is not a tmpfs or hugetlbfs mount";
+            return false;
+        }
+        if (!ProbeMapping(dir, (size_t)fs.f_bsize, error)) {
+            return false;
+        }
+        std::string name(nvm_path);
+        while (name.size() > 1 && name[name.size() - 1] == '/') {
+            name.erase(name.size() - 1);
+        }
+        name = (name.find('/') == std::string::npos) ? name : name.substr(name.find_last_of('/') + 1);
+        snprintf(out, out_size, "%s/%s", dir, name.empty() ? "nvm" : name.c_str());
+        return true;
+    }
+
+    PmemDevice* Device(void)
+    {
+        return &device;
+    }
+
+    const char* Name()
+    {
+        return target->Name();
+    }
+
+    bool Open(const struct engine_options_t* options)
+    {
+        return target->Open(options);
+    }
+
+    void Close()
+    {
+        target->Close();
+    }
+
+public:
+    bool Put(const char* key, size_t key_length, const char* value, size_t value_length)
+    {
+        bool ok = target->Put(key, key_length, value, value_length);
+        if (ok) {
+            device.Write(PmemDevice::Lines(key_length + value_length + PMEM_RECORD_HEADER));
+        }
+        return ok;
+    }
+
+    bool Get(const char* key, size_t key_length, std::string* value)
+    {
+        bool found = target->Get(key, key_length, value);
+        device.Read(1, PmemDevice::Lines(key_length + PMEM_RECORD_HEADER + (found ? value->size() : 0)));
+        return found;
+    }
+
+    bool Delete(const char* key, size_t key_length)
+    {
+        bool ok = target->Delete(key, key_length);
+        if (ok) {
+            device.Write(PmemDevice::Lines(key_length + PMEM_RECORD_HEADER));
+        }
+        return ok;
+    }
+
+    size_t Scan(const char* key, size_t key_length, size_t scan_range, std::vector<std::string>* values)
+    {
+        size_t first = values->size();
+        size_t count = target->Scan(key, key_length, scan_range, values);
+        uint64_t bytes = 0;
+        for (size_t i = first; i < values->size(); i++) {
+            bytes += key_length + PMEM_RECORD_HEADER + (*values)[i].size();
+        }
+        device.Read(1, PmemDevice::Lines(bytes));
+        return count;
+    }
+
+    // The batch is persisted as one record.
+    bool WriteBatch(const struct kv_write_t* writes, size_t num_writes)
+    {
+        bool ok = target->WriteBatch(writes, num_writes);
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < num_writes; i++) {
+            bytes += writes[i].key_length + PMEM_RECORD_HEADER + (writes[i].is_delete ? 0 : writes[i].value_length);
+        }
+        if (ok) {
+            device.Write(PmemDevice::Lines(bytes));
+        }
+        return ok;
+    }
+
+    size_t MultiGet(const char* const* keys, const size_t* key_lengths, size_t num_keys, std::string* values, bool* found)
+    {
+        size_t num_found = target->MultiGet(keys, key_lengths, num_keys, values, found);
+        uint64_t lines = 0;
+        for (size_t i = 0; i < num_keys; i++) {
+            lines += PmemDevice::Lines(key_lengths[i] + PMEM_RECORD_HEADER + (found[i] ? values[i].size() : 0));
+        }
+        device.Read(num_keys, lines);
+        return num_found;
+    }
+
+    KVIterator* NewIterator()
+    {
+        KVIterator* it = target->NewIterator();
+        return (it == nullptr) ? nullptr : new PmemIterator(it, &device);
+    }
+
+    bool Stats(std::string* stats)
+    {
+        return target->Stats(stats);
+    }
+
+    bool Counters(struct engine_stats_t* stats)
+    {
+        return target->Counters(stats);
+    }
+
+private:
+    // Maps one page (a huge page on hugetlbfs) of a scratch file shared and
+    // writes to it, the way the engines use their nvm files.
+    static bool ProbeMapping(const char* dir, size_t page_size, std::string* error)
+    {
+        std::string path = std::string(dir) + "/.pmem_probe";
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            *error = "can not create [" + path + "]: " + strerror(errno);
+            return false;
+        }
+        bool ok = (ftruncate(fd, page_size) == 0);
+        void* addr = ok ? mmap(nullptr, page_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (addr == MAP_FAILED) {
+            *error = "can not map a file in [" + std::string(dir) + "]: " + strerror(errno);
+            ok = false;
+        } else {
+            memset(addr, 0, PMEM_CACHELINE);
+            munmap(addr, page_size);
+        }
+        close(fd);
+        unlink(path.c_str());
+        return ok;
+    }
+
+private:
+    KVEngine* target;
+    PmemDevice device;
+};
+
+#endif
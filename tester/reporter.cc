@@ -0,0 +1,182 @@
+#include "reporter.h"
+
+#include <string.h>
+#include <time.h>
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static uint64_t unix_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+Reporter::Reporter(const char* path, int format, uint64_t interval_ms, Histogram* const* histograms, int num_thread, int num_type, const char* const* type_name)
+    : format(format)
+    , interval_ms(interval_ms)
+    , histograms(histograms)
+    , num_thread(num_thread)
+    , num_type(num_type)
+    , type_name(type_name)
+    , fout(nullptr)
+    , first_row(true)
+    , running(false)
+    , stop(false)
+    , start_ns(0)
+    , last_ns(0)
+    , last(nullptr)
+    , current(nullptr)
+{
+    snprintf(this->path, sizeof(this->path), "%s", path);
+    pthread_mutex_init(&mutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+Reporter::~Reporter()
+{
+    Stop();
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+int Reporter::ParseFormat(const char* name)
+{
+    if (strcmp(name, "csv") == 0) {
+        return REPORT_CSV;
+    } else if (strcmp(name, "json") == 0) {
+        return REPORT_JSON;
+    }
+    return -1;
+}
+
+const char* Reporter::Extension(int format)
+{
+    return (format == REPORT_JSON) ? "json" : "csv";
+}
+
+bool Reporter::Start()
+{
+    if (interval_ms == 0 || running) {
+        return false;
+    }
+    fout = fopen(path, "w");
+    if (fout == nullptr) {
+        printf("Can not open timeline file (%s)\n", path);
+        return false;
+    }
+    if (format == REPORT_JSON) {
+        fprintf(fout, "[\n");
+    } else {
+        fprintf(fout, "time_ms,unix_ms,op,ops,ops_per_sec,avg_ns,p99_ns,p999_ns\n");
+    }
+    last = new Histogram[num_thread * num_type];
+    current = new Histogram[num_thread * num_type];
+    start_ns = last_ns = monotonic_ns();
+    stop = false;
+    running = true;
+    pthread_create(&thread, NULL, ReportTask, (void*)this);
+    return true;
+}
+
+void Reporter::Stop()
+{
+    if (!running) {
+        return;
+    }
+    pthread_mutex_lock(&mutex);
+    stop = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+
+    Report(monotonic_ns());
+    if (format == REPORT_JSON) {
+        fprintf(fout, "\n]\n");
+    }
+    fclose(fout);
+    fout = nullptr;
+    delete[] last;
+    delete[] current;
+    last = current = nullptr;
+    running = false;
+}
+
+void* Reporter::ReportTask(void* args)
+{
+    Reporter* reporter = (Reporter*)args;
+    uint64_t deadline = reporter->start_ns;
+
+    pthread_mutex_lock(&reporter->mutex);
+    while (!reporter->stop) {
+        deadline += reporter->interval_ms * 1000000;
+        struct timespec ts;
+        ts.tv_sec = deadline / 1000000000;
+        ts.tv_nsec = deadline % 1000000000;
+        while (!reporter->stop && monotonic_ns() < deadline) {
+            pthread_cond_timedwait(&reporter->cond, &reporter->mutex, &ts);
+        }
+        if (reporter->stop) {
+            break;
+        }
+        pthread_mutex_unlock(&reporter->mutex);
+        reporter->Report(monotonic_ns());
+        pthread_mutex_lock(&reporter->mutex);
+    }
+    pthread_mutex_unlock(&reporter->mutex);
+    return NULL;
+}
+
+void Reporter::Report(uint64_t now_ns)
+{
+    for (int i = 0; i < num_thread; i++) {
+        for (int j = 0; j < num_type; j++) {
+            histograms[i][j].Snapshot(&current[i * num_type + j]);
+        }
+    }
+
+    double seconds = (now_ns - last_ns) / 1000000000.0;
+    uint64_t time_ms = (now_ns - start_ns) / 1000000;
+    uint64_t wall_ms = unix_ms();
+
+    for (int j = 0; j < num_type; j++) {
+        uint64_t total = 0;
+        interval.Clear();
+        for (int i = 0; i < num_thread; i++) {
+            interval.Merge(current[i * num_type + j]);
+            interval.Subtract(last[i * num_type + j]);
+            total += current[i * num_type + j].Count();
+        }
+        // op types the phase never issues stay out of the timeline.
+        if (total == 0) {
+            continue;
+        }
+        uint64_t ops = interval.Count();
+        double ops_per_sec = (seconds > 0) ? ops / seconds : 0;
+        if (format == REPORT_JSON) {
+            fprintf(fout, "%s{\"time_ms\":%llu,\"unix_ms\":%llu,\"op\":\"%s\",\"ops\":%llu,\"ops_per_sec\":%.1f,\"avg_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu}",
+                first_row ? "" : ",\n", (unsigned long long)time_ms, (unsigned long long)wall_ms, type_name[j], (unsigned long long)ops, ops_per_sec,
+                (unsigned long long)interval.Average(), (unsigned long long)interval.Percentile(0.99), (unsigned long long)interval.Percentile(0.999));
+        } else {
+            fprintf(fout, "%llu,%llu,%s,%llu,%.1f,%llu,%llu,%llu\n",
+                (unsigned long long)time_ms, (unsigned long long)wall_ms, type_name[j], (unsigned long long)ops, ops_per_sec,
+                (unsigned long long)interval.Average(), (unsigned long long)interval.Percentile(0.99), (unsigned long long)interval.Percentile(0.999));
+        }
+        first_row = false;
+    }
+    fflush(fout);
+
+    Histogram* swap = last;
+    last = current;
+    current = swap;
+    last_ns = now_ns;
+}
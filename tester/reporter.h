@@ -0,0 +1,57 @@
+#ifndef INCLUDE_REPORTER_H_
+#define INCLUDE_REPORTER_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "histogram.h"
+
+#define REPORT_CSV (0)
+#define REPORT_JSON (1)
+
+// Background thread that samples the per-thread histograms of a running
+// benchmark every interval_ms and appends one timeline row per op type
+// (ops/s, average, p99 and p99.9 of that interval) to a CSV or JSON file.
+class Reporter {
+public:
+    // histograms[i] points to the num_type histograms of thread i.
+    Reporter(const char* path, int format, uint64_t interval_ms, Histogram* const* histograms, int num_thread, int num_type, const char* const* type_name);
+    ~Reporter();
+
+    bool Start();
+    // Writes the last partial interval and closes the file.
+    void Stop();
+
+    static int ParseFormat(const char* name);
+    static const char* Extension(int format);
+
+private:
+    static void* ReportTask(void* args);
+    void Report(uint64_t now_ns);
+
+private:
+    char path[256];
+    int format;
+    uint64_t interval_ms;
+    Histogram* const* histograms;
+    int num_thread;
+    int num_type;
+    const char* const* type_name;
+
+private:
+    FILE* fout;
+    bool first_row;
+    bool running;
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint64_t start_ns;
+    uint64_t last_ns;
+    Histogram* last; // previous snapshot of every histogram
+    Histogram* current;
+    Histogram interval;
+};
+
+#endif
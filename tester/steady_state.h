@@ -0,0 +1,66 @@
+#ifndef INCLUDE_STEADY_STATE_H_
+#define INCLUDE_STEADY_STATE_H_
+
+#include <math.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Sliding-window throughput stability check. Add() takes the ops/s of one
+// window, the run is steady once the last num_window samples have a
+// coefficient of variation (stddev / mean) no larger than max_cv.
+class SteadyState {
+public:
+    SteadyState(int num_window, double max_cv)
+        : num_window(num_window)
+        , max_cv(max_cv)
+        , num_sample(0)
+        , cv(0)
+        , samples(num_window, 0)
+    {
+    }
+
+    bool Add(double ops_per_sec)
+    {
+        samples[num_sample % num_window] = ops_per_sec;
+        num_sample++;
+        if (num_sample < (uint64_t)num_window) {
+            return false;
+        }
+        double mean = 0;
+        for (int i = 0; i < num_window; i++) {
+            mean += samples[i];
+        }
+        mean /= num_window;
+        if (mean <= 0) {
+            return false;
+        }
+        double variance = 0;
+        for (int i = 0; i < num_window; i++) {
+            variance += (samples[i] - mean) * (samples[i] - mean);
+        }
+        variance /= num_window;
+        cv = sqrt(variance) / mean;
+        return cv <= max_cv;
+    }
+
+    // Coefficient of variation of the last full window set.
+    double CV(void) const
+    {
+        return cv;
+    }
+
+    uint64_t NumSample(void) const
+    {
+        return num_sample;
+    }
+
+private:
+    int num_window;
+    double max_cv;
+    uint64_t num_sample;
+    double cv;
+    std::vector<double> samples;
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "thread_placement.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+static bool read_sysfs(const char* path, char* buf, size_t size)
+{
+    FILE* fin = fopen(path, "r");
+    if (fin == nullptr) {
+        return false;
+    }
+    size_t n = fread(buf, 1, size - 1, fin);
+    fclose(fin);
+    buf[n] = '\0';
+    return n > 0;
+}
+
+ThreadPlacement::ThreadPlacement()
+    : policy(PLACEMENT_NONE)
+{
+}
+
+int ThreadPlacement::ParsePolicy(const char* name)
+{
+    if (strcmp(name, "none") == 0) {
+        return PLACEMENT_NONE;
+    } else if (strcmp(name, "compact") == 0) {
+        return PLACEMENT_COMPACT;
+    } else if (strcmp(name, "scatter") == 0) {
+        return PLACEMENT_SCATTER;
+    } else if (strcmp(name, "per-node") == 0) {
+        return PLACEMENT_PER_NODE;
+    }
+    return -1;
+}
+
+const char* ThreadPlacement::PolicyName(int policy)
+{
+    switch (policy) {
+    case PLACEMENT_COMPACT:
+        return "compact";
+    case PLACEMENT_SCATTER:
+        return "scatter";
+    case PLACEMENT_PER_NODE:
+        return "per-node";
+    case PLACEMENT_CPU_LIST:
+        return "cpu-list";
+    default:
+        return "none";
+    }
+}
+
+bool ThreadPlacement::ParseCpuList(const char* list, std::vector<int>* cpus)
+{
+    const char* p = list;
+    while (*p != '\0' && *p != '\n') {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus->push_back((int)cpu);
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0' && *p != '\n') {
+            return false;
+        }
+    }
+    return !cpus->empty();
+}
+
+bool ThreadPlacement::LoadTopology(void)
+{
+    char buf[4096];
+    char path[128];
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    // only CPUs that are online and that this process may run on are used.
+    std::vector<int> online;
+    if (!read_sysfs("/sys/devices/system/cpu/online", buf, sizeof(buf)) || !ParseCpuList(buf, &online)) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            online.push_back(cpu);
+        }
+    }
+    std::vector<int> usable;
+    for (size_t i = 0; i < online.size(); i++) {
+        if (online[i] < CPU_SETSIZE && CPU_ISSET(online[i], &allowed)) {
+            usable.push_back(online[i]);
+        }
+    }
+    if (usable.empty()) {
+        return false;
+    }
+
+    node_cpus.clear();
+    node_ids.clear();
+    std::vector<int> nodes;
+    if (read_sysfs("/sys/devices/system/node/online", buf, sizeof(buf)) && ParseCpuList(buf, &nodes)) {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            std::vector<int> cpus;
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+            if (!read_sysfs(path, buf, sizeof(buf)) || !ParseCpuList(buf, &cpus)) {
+                continue; // memory-only node
+            }
+            std::vector<int> local;
+            for (size_t j = 0; j < cpus.size(); j++) {
+                if (std::find(usable.begin(), usable.end(), cpus[j]) != usable.end()) {
+                    local.push_back(cpus[j]);
+                }
+            }
+            if (!local.empty()) {
+                node_cpus.push_back(local);
+                node_ids.push_back(nodes[i]);
+            }
+        }
+    }
+    if (node_cpus.empty()) {
+        // kernels without NUMA support have no node directory.
+        node_cpus.push_back(usable);
+        node_ids.push_back(0);
+    }
+
+    sibling_rank.assign(usable.back() + 1, 0);
+    for (size_t i = 0; i < usable.size(); i++) {
+        std::vector<int> siblings;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", usable[i]);
+        if (read_sysfs(path, buf, sizeof(buf)) && ParseCpuList(buf, &siblings)) {
+            std::vector<int>::iterator it = std::find(siblings.begin(), siblings.end(), usable[i]);
+            if (it != siblings.end()) {
+                sibling_rank[usable[i]] = (int)(it - siblings.begin());
+            }
+        }
+    }
+    return true;
+}
+
+bool ThreadPlacement::Init(int policy, const char* cpu_list)
+{
+    this->policy = policy;
+    slots.clear();
+    if (policy == PLACEMENT_NONE) {
+        return true;
+    }
+    if (!LoadTopology()) {
+        return false;
+    }
+
+    std::vector<std::vector<int> > ordered(node_cpus.size());
+    for (size_t n = 0; n < node_cpus.size(); n++) {
+        ordered[n] = node_cpus[n];
+        const std::vector<int>& rank = sibling_rank;
+        std::stable_sort(ordered[n].begin(), ordered[n].end(), [&rank](int a, int b) {
+            return rank[a] < rank[b];
+        });
+    }
+
+    if (policy == PLACEMENT_COMPACT) {
+        for (size_t n = 0; n < ordered.size(); n++) {
+            for (size_t i = 0; i < ordered[n].size(); i++) {
+                slots.push_back(std::vector<int>(1, ordered[n][i]));
+            }
+        }
+    } else if (policy == PLACEMENT_SCATTER) {
+        for (size_t i = 0;; i++) {
+            bool found = false;
+            for (size_t n = 0; n < ordered.size(); n++) {
+                if (i < ordered[n].size()) {
+                    slots.push_back(std::vector<int>(1, ordered[n][i]));
+                    found = true;
+                }
+            }
+            if (!found) {
+                break;
+            }
+        }
+    } else if (policy == PLACEMENT_PER_NODE) {
+        slots = node_cpus;
+    } else if (policy == PLACEMENT_CPU_LIST) {
+        std::vector<int> cpus;
+        if (cpu_list == nullptr || !ParseCpuList(cpu_list, &cpus)) {
+            return false;
+        }
+        for (size_t i = 0; i < cpus.size(); i++) {
+            if (cpus[i] >= CPU_SETSIZE) {
+                return false;
+            }
+            slots.push_back(std::vector<int>(1, cpus[i]));
+        }
+    } else {
+        return false;
+    }
+    return !slots.empty();
+}
+
+bool ThreadPlacement::Bind(int thread_id) const
+{
+    if (slots.empty()) {
+        return false;
+    }
+    const std::vector<int>& cpus = slots[thread_id % slots.size()];
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (size_t i = 0; i < cpus.size(); i++) {
+        CPU_SET(cpus[i], &mask);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
+
+int ThreadPlacement::NodeOf(int cpu) const
+{
+    for (size_t n = 0; n < node_cpus.size(); n++) {
+        if (std::find(node_cpus[n].begin(), node_cpus[n].end(), cpu) != node_cpus[n].end()) {
+            return node_ids[n];
+        }
+    }
+    return -1;
+}
+
+std::string ThreadPlacement::ToString(int thread_id) const
+{
+    if (slots.empty()) {
+        return "unbound";
+    }
+    const std::vector<int>& cpus = slots[thread_id % slots.size()];
+    char buf[64];
+    if (cpus.size() == 1) {
+        snprintf(buf, sizeof(buf), "node%d:cpu%d", NodeOf(cpus[0]), cpus[0]);
+    } else {
+        snprintf(buf, sizeof(buf), "node%d:%zucpus", NodeOf(cpus[0]), cpus.size());
+    }
+    return std::string(buf);
+}
@@ -0,0 +1,71 @@
+#ifndef INCLUDE_THREAD_PLACEMENT_H_
+#define INCLUDE_THREAD_PLACEMENT_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Per-thread state written on the hot path is aligned to this to avoid false sharing.
+#define CACHE_LINE_SIZE (64)
+
+#define PLACEMENT_NONE (0)
+// fill one node (physical cores before their hyper-threads) before the next
+#define PLACEMENT_COMPACT (1)
+// spread consecutive threads round-robin over the nodes
+#define PLACEMENT_SCATTER (2)
+// bind every thread to all CPUs of one node, nodes taken round-robin
+#define PLACEMENT_PER_NODE (3)
+// bind thread i to the i-th CPU of --cpu_list
+#define PLACEMENT_CPU_LIST (4)
+
+// Maps benchmark threads to CPUs using the topology in /sys/devices/system.
+// Threads bind themselves before allocating anything they write, so first-touch
+// places their buffers on their local node without linking libnuma.
+class ThreadPlacement {
+public:
+    ThreadPlacement();
+
+    // cpu_list ("0-3,8,10-11") is only used by PLACEMENT_CPU_LIST.
+    bool Init(int policy, const char* cpu_list);
+
+    // Pins the calling thread to the CPUs planned for thread_id (wrapping around
+    // when there are more threads than slots).
+    bool Bind(int thread_id) const;
+
+    // "node0:cpu3" style description of the slot of thread_id.
+    std::string ToString(int thread_id) const;
+
+    int Policy(void) const
+    {
+        return policy;
+    }
+
+    int NumNode(void) const
+    {
+        return (int)node_cpus.size();
+    }
+
+    // Distinct CPU sets Bind() hands out before it wraps around, 0 for PLACEMENT_NONE.
+    int NumSlot(void) const
+    {
+        return (int)slots.size();
+    }
+
+    static int ParsePolicy(const char* name);
+    static const char* PolicyName(int policy);
+    static bool ParseCpuList(const char* list, std::vector<int>* cpus);
+
+private:
+    bool LoadTopology(void);
+    int NodeOf(int cpu) const;
+
+private:
+    int policy;
+    std::vector<std::vector<int> > node_cpus; // usable CPUs of each node
+    std::vector<int> node_ids;
+    std::vector<int> sibling_rank; // by CPU, 0 for the first hyper-thread of a core
+    std::vector<std::vector<int> > slots; // CPU set of each thread slot
+};
+
+#endif
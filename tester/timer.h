@@ -0,0 +1,242 @@
+#ifndef UTIL_TIMER_H_
+#define UTIL_TIMER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Read the TSC when the CPU has an invariant one (constant_tsc and nonstop_tsc,
+// plus rdtscp), its rate is calibrated against CLOCK_MONOTONIC once per
+// process. Without RDTSC_CLOCK, or on a CPU without such a TSC, everything
+// falls back to clock_gettime (vDSO).
+#define RDTSC_CLOCK
+// the calibration spins this long between its two readings of both clocks
+#define TSC_CALIBRATION_NS (20000000ULL)
+// a reading of both clocks is retried until the TSC read is this tight
+#define TSC_CALIBRATION_TRIES (16)
+
+// Process-wide time source. Now() is in ns on the CLOCK_MONOTONIC time line (it
+// only drifts from it by the calibration error, a few ppm), Ticks() is a raw
+// counter for intervals that ToNs() converts.
+class TscClock {
+public:
+    static const TscClock& Get(void)
+    {
+        // initialised once, thread-safe since C++11.
+        static TscClock clock;
+        return clock;
+    }
+
+    uint64_t Now(void) const
+    {
+        return tsc ? base_ns + ToNs(ReadTsc() - base_tsc) : MonotonicNs();
+    }
+
+    uint64_t Ticks(void) const
+    {
+        return tsc ? ReadTsc() : MonotonicNs();
+    }
+
+    uint64_t ToNs(uint64_t ticks) const
+    {
+        // 32.32 fixed point, exact enough and a single multiply.
+        return tsc ? (uint64_t)(((unsigned __int128)ticks * mult) >> 32) : ticks;
+    }
+
+    bool UsesTsc(void) const
+    {
+        return tsc;
+    }
+
+    // TSC rate, 0 on the clock_gettime fallback.
+    double GHz(void) const
+    {
+        return tsc ? ghz : 0;
+    }
+
+    // "tsc" or "clock_gettime (<why the TSC is not used>)".
+    const char* Source(void) const
+    {
+        return source;
+    }
+
+    static uint64_t MonotonicNs(void)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    }
+
+private:
+    TscClock()
+        : tsc(false)
+        , mult(0)
+        , base_tsc(0)
+        , base_ns(0)
+        , ghz(0)
+    {
+        const char* reason = InvariantTsc();
+        if (reason == nullptr) {
+            Calibrate();
+            tsc = (ghz > 0);
+            reason = tsc ? nullptr : "calibration failed";
+        }
+        if (tsc) {
+            snprintf(source, sizeof(source), "tsc");
+        } else {
+            snprintf(source, sizeof(source), "clock_gettime (%s)", reason);
+        }
+    }
+
+    static uint64_t ReadTsc(void)
+    {
+#if (defined RDTSC_CLOCK) && (defined __x86_64__ || defined __i386__)
+        unsigned hi, lo;
+        // rdtscp waits for earlier instructions, so the op being timed is inside.
+        __asm__ __volatile__("rdtscp"
+                             : "=a"(lo), "=d"(hi)::"rcx");
+        return ((uint64_t)lo) | (((uint64_t)hi) << 32);
+#else
+        return 0;
+#endif
+    }
+
+    // nullptr if the TSC can be used, else why not.
+    static const char* InvariantTsc(void)
+    {
+#if (defined RDTSC_CLOCK) && (defined __x86_64__ || defined __i386__)
+        FILE* fin = fopen("/proc/cpuinfo", "r");
+        if (fin == nullptr) {
+            return "no /proc/cpuinfo";
+        }
+        char line[4096];
+        const char* reason = "no cpu flags";
+        while (fgets(line, sizeof(line), fin) != nullptr) {
+            if (strncmp(line, "flags", 5) != 0) {
+                continue;
+            }
+            // only the first cpu is checked, the kernel clears the flags on all of them.
+            if (!HasFlag(line, "constant_tsc")) {
+                reason = "no constant_tsc";
+            } else if (!HasFlag(line, "nonstop_tsc")) {
+                reason = "no nonstop_tsc";
+            } else if (!HasFlag(line, "rdtscp")) {
+                reason = "no rdtscp";
+            } else {
+                reason = nullptr;
+            }
+            break;
+        }
+        fclose(fin);
+        return reason;
+#elif (defined RDTSC_CLOCK)
+        return "not x86";
+#else
+        return "RDTSC_CLOCK off";
+#endif
+    }
+
+    static bool HasFlag(const char* flags, const char* flag)
+    {
+        size_t n = strlen(flag);
+        for (const char* p = strstr(flags, flag); p != nullptr; p = strstr(p + 1, flag)) {
+            if ((p[-1] == ' ' || p[-1] == '\t') && (p[n] == ' ' || p[n] == '\n' || p[n] == '\0')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // One TSC reading and the CLOCK_MONOTONIC time in the middle of it, from
+    // the try whose two clock_gettime calls were closest together.
+    static void ReadBoth(uint64_t* tsc_value, uint64_t* ns)
+    {
+        uint64_t best = UINT64_MAX;
+        *tsc_value = 0;
+        *ns = 0;
+        for (int i = 0; i < TSC_CALIBRATION_TRIES; i++) {
+            uint64_t before = MonotonicNs();
+            uint64_t t = ReadTsc();
+            uint64_t after = MonotonicNs();
+            if (after - before < best) {
+                best = after - before;
+                *tsc_value = t;
+                *ns = before + (after - before) / 2;
+            }
+        }
+    }
+
+    void Calibrate(void)
+    {
+        uint64_t tsc0, ns0, tsc1, ns1;
+        ReadBoth(&tsc0, &ns0);
+        while (MonotonicNs() - ns0 < TSC_CALIBRATION_NS) {
+        }
+        ReadBoth(&tsc1, &ns1);
+        if (tsc1 <= tsc0 || ns1 <= ns0) {
+            return;
+        }
+        ghz = (double)(tsc1 - tsc0) / (ns1 - ns0);
+        mult = (uint64_t)((double)(ns1 - ns0) / (tsc1 - tsc0) * 4294967296.0 + 0.5);
+        base_tsc = tsc1;
+        base_ns = ns1;
+    }
+
+private:
+    bool tsc;
+    uint64_t mult; // ns per tick << 32
+    uint64_t base_tsc;
+    uint64_t base_ns; // CLOCK_MONOTONIC time at base_tsc
+    double ghz;
+    char source[64];
+};
+
+// Times one interval at a time (Start/Stop) or sums several (Start/Accumulate).
+class Timer {
+public:
+    Timer(void)
+        : clock(TscClock::Get())
+        , start(0)
+        , elapsed(0)
+    {
+    }
+
+    void Start(void)
+    {
+        start = clock.Ticks();
+    }
+
+    void Stop(void)
+    {
+        elapsed = clock.Ticks() - start;
+    }
+
+    void Accumulate(void)
+    {
+        elapsed += clock.Ticks() - start;
+    }
+
+    // ns of the last Stop() (or the sum of the Accumulate()s).
+    size_t Get(void)
+    {
+        return clock.ToNs(elapsed);
+    }
+
+    double GetSeconds(void)
+    {
+        return clock.ToNs(elapsed) / 1000000000.0;
+    }
+
+    size_t Now(void)
+    {
+        return clock.Now();
+    }
+
+private:
+    const TscClock& clock;
+    uint64_t start;
+    uint64_t elapsed;
+};
+
+#endif // UTIL_TIMER_H_
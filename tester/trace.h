@@ -0,0 +1,251 @@
+#ifndef INCLUDE_TRACE_H_
+#define INCLUDE_TRACE_H_
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mutex>
+
+// Binary request trace: a trace_header_t followed by num_record records. Each
+// record is a trace_record_t and key_length key bytes, padded to 8 bytes so
+// every record header is aligned inside the mmap'ed file.
+#define TRACE_MAGIC (0x314543415254564BULL) // "KVTRACE1"
+#define TRACE_VERSION (1)
+#define TRACE_ALIGN (8)
+#define TRACE_MAX_KEY_LENGTH (255)
+
+#define TRACE_PUT (0)
+#define TRACE_GET (1)
+#define TRACE_DELETE (2)
+#define TRACE_SCAN (3) // value_length holds the scan range
+#define TRACE_OP_COUNT (4)
+
+struct trace_header_t {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t max_key_length;
+    uint64_t num_record;
+    uint64_t max_value_length;
+    uint64_t duration_ns; // sum of all delta_ns
+    uint64_t reserved[3];
+};
+
+struct trace_record_t {
+    uint8_t op;
+    uint8_t key_length;
+    uint16_t reserved;
+    uint32_t value_length;
+    uint64_t delta_ns; // since the previous record of the trace
+};
+
+static inline size_t trace_record_size(size_t key_length)
+{
+    return (sizeof(trace_record_t) + key_length + TRACE_ALIGN - 1) & ~(size_t)(TRACE_ALIGN - 1);
+}
+
+// FNV-1a, used to partition a trace over replay threads by key.
+static inline uint64_t trace_key_hash(const char* key, size_t key_length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < key_length; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static inline const char* trace_op_name(int op)
+{
+    static const char* names[TRACE_OP_COUNT] = { "PUT", "GET", "DELETE", "SCAN" };
+    return (op >= 0 && op < TRACE_OP_COUNT) ? names[op] : "UNKNOWN";
+}
+
+// Appends records from any number of threads in the order they arrive, each
+// stamped with the time since the previous one. The header is rewritten with
+// the final counts by Close(). A key longer than TRACE_MAX_KEY_LENGTH can not
+// be replayed as it was sent, its request is left out and only counted
+// (NumRejected()).
+class TraceWriter {
+public:
+    TraceWriter()
+        : file(nullptr)
+        , last_ns(0)
+        , num_rejected(0)
+    {
+        memset(&header, 0, sizeof(header));
+    }
+
+    ~TraceWriter()
+    {
+        Close();
+    }
+
+    bool Open(const char* path)
+    {
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        memset(&header, 0, sizeof(header));
+        header.magic = TRACE_MAGIC;
+        header.version = TRACE_VERSION;
+        last_ns = 0;
+        num_rejected = 0;
+        return fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    void Append(int op, const char* key, size_t key_length, size_t value_length)
+    {
+        if (key_length > TRACE_MAX_KEY_LENGTH) {
+            std::lock_guard<std::mutex> lock(mutex);
+            num_rejected++;
+            return;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+        char buf[sizeof(trace_record_t) + TRACE_MAX_KEY_LENGTH + TRACE_ALIGN];
+        trace_record_t* record = (trace_record_t*)buf;
+        size_t size = trace_record_size(key_length);
+        memset(buf, 0, size);
+        record->op = op;
+        record->key_length = key_length;
+        record->value_length = (value_length > UINT32_MAX) ? UINT32_MAX : value_length;
+        memcpy(buf + sizeof(trace_record_t), key, key_length);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file == nullptr) {
+            return;
+        }
+        // the first record starts the trace, a thread that read the clock before
+        // another one but got the lock later is stamped with no gap.
+        record->delta_ns = (last_ns == 0 || now_ns < last_ns) ? 0 : now_ns - last_ns;
+        last_ns = (now_ns > last_ns) ? now_ns : last_ns;
+        fwrite(buf, size, 1, file);
+        header.num_record++;
+        header.duration_ns += record->delta_ns;
+        if (key_length > header.max_key_length) {
+            header.max_key_length = key_length;
+        }
+        if (record->value_length > header.max_value_length && op != TRACE_SCAN) {
+            header.max_value_length = record->value_length;
+        }
+    }
+
+    uint64_t NumRecord(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return header.num_record;
+    }
+
+    // Requests left out because their key was too long.
+    uint64_t NumRejected(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return num_rejected;
+    }
+
+    void Close(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file == nullptr) {
+            return;
+        }
+        fseek(file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, file);
+        fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file;
+    trace_header_t header;
+    uint64_t last_ns;
+    uint64_t num_rejected;
+    std::mutex mutex;
+};
+
+// Read-only view of a trace file. The file is mapped once and shared by all
+// readers, each of which walks it with its own offset.
+class TraceReader {
+public:
+    TraceReader()
+        : base(nullptr)
+        , size(0)
+    {
+    }
+
+    ~TraceReader()
+    {
+        if (base != nullptr) {
+            munmap((void*)base, size);
+        }
+    }
+
+    bool Open(const char* path)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(trace_header_t)) {
+            close(fd);
+            return false;
+        }
+        size = st.st_size;
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        base = (const char*)addr;
+        // replay walks the file front to back, let the kernel read ahead aggressively.
+        madvise(addr, size, MADV_SEQUENTIAL);
+        madvise(addr, size, MADV_WILLNEED);
+        const trace_header_t* header = Header();
+        return header->magic == TRACE_MAGIC && header->version == TRACE_VERSION;
+    }
+
+    const trace_header_t* Header(void) const
+    {
+        return (const trace_header_t*)base;
+    }
+
+    // Offset of the first record.
+    uint64_t Begin(void) const
+    {
+        return sizeof(trace_header_t);
+    }
+
+    // Returns the record at *offset and moves *offset past it, nullptr at the
+    // end of the trace (or at a truncated record).
+    const trace_record_t* Next(uint64_t* offset, const char** key) const
+    {
+        if (*offset + sizeof(trace_record_t) > size) {
+            return nullptr;
+        }
+        const trace_record_t* record = (const trace_record_t*)(base + *offset);
+        size_t record_size = trace_record_size(record->key_length);
+        if (*offset + record_size > size) {
+            return nullptr;
+        }
+        *key = base + *offset + sizeof(trace_record_t);
+        *offset += record_size;
+        return record;
+    }
+
+private:
+    const char* base;
+    size_t size;
+};
+
+#endif
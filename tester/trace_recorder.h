@@ -0,0 +1,119 @@
+#ifndef INCLUDE_TRACE_RECORDER_H_
+#define INCLUDE_TRACE_RECORDER_H_
+
+#include "kv_engine.h"
+#include "trace.h"
+
+// Wraps any engine adapter and appends every request to a trace before passing
+// it on. Batched writes and MultiGet are recorded as their single requests,
+// iterators are passed through unrecorded. The trace is complete after Close().
+class TraceRecorder : public KVEngine {
+public:
+    // Takes ownership of target.
+    explicit TraceRecorder(KVEngine* target)
+        : target(target)
+    {
+    }
+
+    ~TraceRecorder()
+    {
+        delete target;
+    }
+
+    bool OpenTrace(const char* path)
+    {
+        return writer.Open(path);
+    }
+
+    uint64_t NumRecord(void)
+    {
+        return writer.NumRecord();
+    }
+
+    uint64_t NumRejected(void)
+    {
+        return writer.NumRejected();
+    }
+
+    const char* Name()
+    {
+        return target->Name();
+    }
+
+    bool Open(const struct engine_options_t* options)
+    {
+        return target->Open(options);
+    }
+
+    void Close()
+    {
+        target->Close();
+        writer.Close();
+    }
+
+public:
+    bool Put(const char* key, size_t key_length, const char* value, size_t value_length)
+    {
+        writer.Append(TRACE_PUT, key, key_length, value_length);
+        return target->Put(key, key_length, value, value_length);
+    }
+
+    bool Get(const char* key, size_t key_length, std::string* value)
+    {
+        writer.Append(TRACE_GET, key, key_length, 0);
+        return target->Get(key, key_length, value);
+    }
+
+    bool Delete(const char* key, size_t key_length)
+    {
+        writer.Append(TRACE_DELETE, key, key_length, 0);
+        return target->Delete(key, key_length);
+    }
+
+    size_t Scan(const char* key, size_t key_length, size_t scan_range, std::vector<std::string>* values)
+    {
+        writer.Append(TRACE_SCAN, key, key_length, scan_range);
+        return target->Scan(key, key_length, scan_range, values);
+    }
+
+    bool WriteBatch(const struct kv_write_t* writes, size_t num_writes)
+    {
+        for (size_t i = 0; i < num_writes; i++) {
+            if (writes[i].is_delete) {
+                writer.Append(TRACE_DELETE, writes[i].key, writes[i].key_length, 0);
+            } else {
+                writer.Append(TRACE_PUT, writes[i].key, writes[i].key_length, writes[i].value_length);
+            }
+        }
+        return target->WriteBatch(writes, num_writes);
+    }
+
+    size_t MultiGet(const char* const* keys, const size_t* key_lengths, size_t num_keys, std::string* values, bool* found)
+    {
+        for (size_t i = 0; i < num_keys; i++) {
+            writer.Append(TRACE_GET, keys[i], key_lengths[i], 0);
+        }
+        return target->MultiGet(keys, key_lengths, num_keys, values, found);
+    }
+
+    KVIterator* NewIterator()
+    {
+        return target->NewIterator();
+    }
+
+    bool Stats(std::string* stats)
+    {
+        return target->Stats(stats);
+    }
+
+    bool Counters(struct engine_stats_t* stats)
+    {
+        return target->Counters(stats);
+    }
+
+private:
+    KVEngine* target;
+    TraceWriter writer;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef INCLUDE_VALUE_GENERATOR_H_
+#define INCLUDE_VALUE_GENERATOR_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "xorshift.h"
+
+#define VALUE_FIXED (0)
+#define VALUE_UNIFORM (1) // uniform in [min, max]
+#define VALUE_ZIPF (2) // zipfian over [min, max], min is the most common size
+#define VALUE_LOGNORMAL (3) // median * e^(sigma * N(0, 1))
+#define VALUE_HISTOGRAM (4) // empirical, "<upper bound> <weight>" lines of a file
+
+#define VALUE_ZIPF_THETA (0.99)
+// the compressible pool is cut into pieces of this many bytes, as in db_bench.
+#define VALUE_PIECE_LENGTH (100)
+#define VALUE_POOL_SIZE (1 << 20)
+
+// Value lengths drawn per put. Written as "1024" (or "fixed:1024"),
+// "uniform:100-4000", "zipf:64-4096", "lognormal:1024,0.5" (median, sigma) or
+// "file:path". The tables are built by Parse(), Next() only reads them, so one
+// distribution is shared by all threads of a phase.
+class ValueSize {
+public:
+    ValueSize()
+        : type(VALUE_FIXED)
+        , min_size(1024)
+        , max_size(1024)
+        , median(1024)
+        , sigma(0)
+    {
+    }
+
+    // Returns false with the reason in *error.
+    bool Parse(const char* spec, std::string* error)
+    {
+        unsigned long long a, b;
+        double m, s;
+        char junk;
+        text = spec;
+        bounds.clear();
+        cdf.clear();
+        if (sscanf(spec, "%llu%c", &a, &junk) == 1 || sscanf(spec, "fixed:%llu%c", &a, &junk) == 1) {
+            type = VALUE_FIXED;
+            min_size = max_size = a;
+        } else if (sscanf(spec, "uniform:%llu-%llu%c", &a, &b, &junk) == 2 && a <= b) {
+            type = VALUE_UNIFORM;
+            min_size = a;
+            max_size = b;
+        } else if (sscanf(spec, "zipf:%llu-%llu%c", &a, &b, &junk) == 2 && a <= b) {
+            type = VALUE_ZIPF;
+            min_size = a;
+            max_size = b;
+            double sum = 0;
+            for (uint64_t i = 0; i <= b - a; i++) {
+                sum += 1 / pow((double)(i + 1), VALUE_ZIPF_THETA);
+                cdf.push_back(sum);
+            }
+            for (size_t i = 0; i < cdf.size(); i++) {
+                cdf[i] /= sum;
+            }
+        } else if (sscanf(spec, "lognormal:%lf,%lf%c", &m, &s, &junk) == 2 && m >= 1 && s >= 0) {
+            type = VALUE_LOGNORMAL;
+            median = m;
+            sigma = s;
+            min_size = 1;
+            max_size = SIZE_MAX;
+        } else if (strncmp(spec, "file:", 5) == 0) {
+            type = VALUE_HISTOGRAM;
+            return LoadHistogram(spec + 5, error);
+        } else {
+            *error = std::string("bad value size [") + spec + "]";
+            return false;
+        }
+        if (max_size == 0) {
+            *error = std::string("empty value size [") + spec + "]";
+            return false;
+        }
+        return true;
+    }
+
+    // Keeps every draw inside [lo, hi], the room the caller has for a value
+    // and the bytes it stamps into it.
+    void Clamp(size_t lo, size_t hi)
+    {
+        min_size = std::min(std::max(min_size, lo), hi);
+        max_size = std::min(std::max(max_size, lo), hi);
+    }
+
+    size_t Next(uint64_t* state) const
+    {
+        size_t size;
+        switch (type) {
+        case VALUE_UNIFORM:
+            size = min_size + xorshift_random(state) % (max_size - min_size + 1);
+            break;
+        case VALUE_ZIPF:
+            size = min_size + (std::lower_bound(cdf.begin(), cdf.end(), xorshift_double(state)) - cdf.begin());
+            break;
+        case VALUE_LOGNORMAL: {
+            // Box-Muller, 1 - u keeps the log argument away from 0.
+            double u1 = 1.0 - xorshift_double(state);
+            double u2 = xorshift_double(state);
+            double z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+            double v = median * exp(sigma * z);
+            size = (v >= (double)max_size) ? max_size : (size_t)(v + 0.5);
+            break;
+        }
+        case VALUE_HISTOGRAM: {
+            size_t i = std::lower_bound(cdf.begin(), cdf.end(), xorshift_double(state)) - cdf.begin();
+            i = (i < bounds.size()) ? i : bounds.size() - 1;
+            size_t lo = (i == 0) ? 1 : bounds[i - 1] + 1;
+            size = lo + xorshift_random(state) % (bounds[i] - lo + 1);
+            break;
+        }
+        default:
+            return max_size;
+        }
+        return std::min(std::max(size, min_size), max_size);
+    }
+
+    bool Fixed(void) const
+    {
+        return type == VALUE_FIXED;
+    }
+
+    size_t Max(void) const
+    {
+        return max_size;
+    }
+
+    const char* ToString(void) const
+    {
+        return text.c_str();
+    }
+
+private:
+    // Every line is "<upper bound> <weight>", the bucket covers the sizes past
+    // the bound of the line before, up to its own bound.
+    bool LoadHistogram(const char* path, std::string* error)
+    {
+        FILE* fin = fopen(path, "r");
+        if (fin == nullptr) {
+            *error = std::string("can not open ") + path;
+            return false;
+        }
+        char line[256];
+        int line_no = 0;
+        double sum = 0;
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), fin) != nullptr) {
+            line_no++;
+            unsigned long long bound;
+            double weight;
+            if (line[strspn(line, " \t\r\n")] == '\0' || line[strspn(line, " \t")] == '#') {
+                continue;
+            }
+            if (sscanf(line, "%llu %lf", &bound, &weight) != 2 || bound == 0 || weight < 0
+                || (!bounds.empty() && bound <= bounds.back())) {
+                char buf[300];
+                snprintf(buf, sizeof(buf), "%s line %d: expected increasing <upper bound> <weight>", path, line_no);
+                *error = buf;
+                ok = false;
+            } else {
+                sum += weight;
+                bounds.push_back(bound);
+                cdf.push_back(sum);
+            }
+        }
+        fclose(fin);
+        if (ok && sum <= 0) {
+            *error = std::string(path) + " has no weight";
+            ok = false;
+        }
+        if (ok) {
+            for (size_t i = 0; i < cdf.size(); i++) {
+                cdf[i] /= sum;
+            }
+            min_size = 1;
+            max_size = bounds.back();
+        }
+        return ok;
+    }
+
+private:
+    int type;
+    size_t min_size;
+    size_t max_size;
+    double median;
+    double sigma;
+    std::vector<size_t> bounds; // VALUE_HISTOGRAM bucket upper bounds
+    std::vector<double> cdf; // VALUE_ZIPF per size, VALUE_HISTOGRAM per bucket
+    std::string text;
+};
+
+// Payload bytes that compress to about compression_ratio of their size, built
+// like db_bench's RandomGenerator: every VALUE_PIECE_LENGTH piece of a pool is
+// ratio * VALUE_PIECE_LENGTH random bytes repeated to fill it, and values are
+// consecutive slices of the pool. A ratio of 1 is incompressible. Not thread
+// safe, every thread owns one.
+class ValueGenerator {
+public:
+    ValueGenerator(double compression_ratio, uint64_t seed, size_t max_length)
+        : pos(0)
+    {
+        uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+        size_t raw = (size_t)(VALUE_PIECE_LENGTH * compression_ratio + 0.5);
+        raw = (raw == 0) ? 1 : std::min(raw, (size_t)VALUE_PIECE_LENGTH);
+        data.resize(std::max((size_t)VALUE_POOL_SIZE, max_length));
+        for (size_t off = 0; off < data.size(); off += VALUE_PIECE_LENGTH) {
+            size_t piece = std::min((size_t)VALUE_PIECE_LENGTH, data.size() - off);
+            for (size_t i = 0; i < piece; i++) {
+                data[off + i] = (i < raw) ? (char)xorshift_random(&state) : data[off + i % raw];
+            }
+        }
+    }
+
+    // The next length bytes of the pool, valid until the generator is destroyed.
+    const char* Generate(size_t length)
+    {
+        if (pos + length > data.size()) {
+            pos = 0;
+        }
+        pos += length;
+        return &data[pos - length];
+    }
+
+private:
+    std::vector<char> data;
+    size_t pos;
+};
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef INCLUDE_WORKLOAD_SPEC_H_
+#define INCLUDE_WORKLOAD_SPEC_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "arrival.h"
+#include "value_generator.h"
+
+// Op types a phase can mix, not every driver runs all of them.
+#define SPEC_PUT (0) // write a new key
+#define SPEC_UPDATE (1) // overwrite a loaded key
+#define SPEC_GET (2)
+#define SPEC_DELETE (3)
+#define SPEC_SCAN (4)
+#define SPEC_RMW (5) // ycsb-example only
+#define SPEC_MULTIGET (6) // tester only
+#define SPEC_OP_COUNT (7)
+
+// One phase of a workload spec. Fields left out of a section are taken from the
+// top of the file, then from these defaults.
+struct phase_spec_t {
+    std::string name;
+    double mix[SPEC_OP_COUNT]; // relative weights
+    std::string distribution; // sequential, uniform, zipfian, scrambled, hotspot or exponential
+    double hot_set_fraction;
+    double hot_op_fraction;
+    uint64_t num_keys; // key space the phase draws from (sequential: writes)
+    uint64_t num_ops; // 0 runs num_keys ops
+    uint64_t duration; // seconds, runs the mix until then instead of num_ops
+    uint64_t target_qps; // 0 is closed-loop
+    int arrival;
+    std::string value_size; // ValueSize syntax, a length or a distribution
+    size_t key_length; // tester only, ycsb-example keys are 8 bytes
+    size_t scan_range;
+    int num_thread; // 0 keeps the command-line thread count
+
+    phase_spec_t()
+    {
+        memset(mix, 0, sizeof(mix));
+        distribution = "uniform";
+        hot_set_fraction = 0.2;
+        hot_op_fraction = 0.8;
+        num_keys = 1000000;
+        num_ops = 0;
+        duration = 0;
+        target_qps = 0;
+        arrival = ARRIVAL_CONSTANT;
+        value_size = "1024";
+        key_length = 16;
+        scan_range = 100;
+        num_thread = 0;
+    }
+
+    uint64_t NumOps(void) const
+    {
+        return (num_ops > 0) ? num_ops : num_keys;
+    }
+
+    double MixTotal(void) const
+    {
+        double total = 0;
+        for (int i = 0; i < SPEC_OP_COUNT; i++) {
+            total += mix[i];
+        }
+        return total;
+    }
+
+    // Ops of type op out of NumOps(), by its share of the mix.
+    uint64_t OpsOf(int op) const
+    {
+        double total = MixTotal();
+        return (total > 0) ? (uint64_t)(NumOps() * mix[op] / total + 0.5) : 0;
+    }
+};
+
+// A workload spec file, for example:
+//
+//   # defaults of every phase
+//   keys = 1000000
+//   value_size = lognormal:1024,0.5
+//
+//   [load]
+//   mix = put:100
+//   distribution = sequential
+//
+//   [steady]
+//   mix = get:95, update:5
+//   distribution = zipfian
+//   duration = 60
+//   rate = 50000
+//
+// Phases run in file order inside one process, so the engine stays warm. Keys:
+// mix (put, update, get, delete, scan, rmw, multiget with weights), distribution,
+// hot_set_fraction, hot_op_fraction, keys, ops, duration (s), rate (ops/s),
+// arrival (constant or poisson), value_size (a length, or uniform:min-max,
+// zipf:min-max, lognormal:median,sigma or file:path), key_length, scan_range,
+// threads.
+class WorkloadSpec {
+public:
+    static const char* OpName(int op)
+    {
+        static const char* names[SPEC_OP_COUNT] = { "put", "update", "get", "delete", "scan", "rmw", "multiget" };
+        return names[op];
+    }
+
+    // Returns false with a "line N: ..." message in *error.
+    bool Load(const char* path, std::string* error)
+    {
+        FILE* fin = fopen(path, "r");
+        if (fin == nullptr) {
+            *error = std::string("can not open ") + path;
+            return false;
+        }
+        phases.clear();
+        phase_spec_t defaults;
+        phase_spec_t* current = &defaults;
+        char line[1024];
+        int line_no = 0;
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), fin) != nullptr) {
+            line_no++;
+            char* hash = strchr(line, '#');
+            if (hash != nullptr) {
+                *hash = '\0';
+            }
+            char* p = Trim(line);
+            if (*p == '\0') {
+                continue;
+            }
+            char message[256] = "";
+            if (*p == '[') {
+                char* end = strchr(p, ']');
+                if (end == nullptr || end == p + 1) {
+                    snprintf(message, sizeof(message), "bad phase header");
+                } else {
+                    *end = '\0';
+                    phases.push_back(defaults);
+                    phases.back().name = Trim(p + 1);
+                    current = &phases.back();
+                }
+            } else {
+                char* eq = strchr(p, '=');
+                if (eq == nullptr) {
+                    snprintf(message, sizeof(message), "expected key = value");
+                } else {
+                    *eq = '\0';
+                    Set(current, Trim(p), Trim(eq + 1), message, sizeof(message));
+                }
+            }
+            if (message[0] != '\0') {
+                char buf[300];
+                snprintf(buf, sizeof(buf), "line %d: %s", line_no, message);
+                *error = buf;
+                ok = false;
+            }
+        }
+        fclose(fin);
+        if (ok && phases.empty()) {
+            *error = "no [phase] section";
+            ok = false;
+        }
+        for (size_t i = 0; ok && i < phases.size(); i++) {
+            if (phases[i].MixTotal() <= 0) {
+                *error = "phase [" + phases[i].name + "] has no mix";
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    std::vector<phase_spec_t> phases;
+
+private:
+    static char* Trim(char* s)
+    {
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        size_t n = strlen(s);
+        while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\n' || s[n - 1] == '\r')) {
+            s[--n] = '\0';
+        }
+        return s;
+    }
+
+    static bool ParseNumber(const char* value, uint64_t* n)
+    {
+        char* end;
+        unsigned long long v = strtoull(value, &end, 10);
+        if (end == value || *end != '\0') {
+            return false;
+        }
+        *n = v;
+        return true;
+    }
+
+    static bool ParseFraction(const char* value, double* d)
+    {
+        char* end;
+        double v = strtod(value, &end);
+        if (end == value || *end != '\0' || v < 0 || v > 1) {
+            return false;
+        }
+        *d = v;
+        return true;
+    }
+
+    // "get:95, update:5"
+    static bool ParseMix(char* value, double* mix)
+    {
+        double parsed[SPEC_OP_COUNT] = { 0 };
+        for (char* item = strtok(value, ","); item != nullptr; item = strtok(nullptr, ",")) {
+            char* colon = strchr(item, ':');
+            if (colon == nullptr) {
+                return false;
+            }
+            *colon = '\0';
+            char* op = Trim(item);
+            char* end;
+            double weight = strtod(Trim(colon + 1), &end);
+            if (*end != '\0' || weight < 0) {
+                return false;
+            }
+            int i = 0;
+            while (i < SPEC_OP_COUNT && strcmp(op, OpName(i)) != 0) {
+                i++;
+            }
+            if (i == SPEC_OP_COUNT) {
+                return false;
+            }
+            parsed[i] += weight;
+        }
+        memcpy(mix, parsed, sizeof(parsed));
+        return true;
+    }
+
+    static void Set(phase_spec_t* phase, const char* key, char* value, char* message, size_t size)
+    {
+        uint64_t number = 0;
+        uint64_t* field = nullptr;
+        size_t* size_field = nullptr;
+        bool ok = true;
+        if (strcmp(key, "mix") == 0) {
+            ok = ParseMix(value, phase->mix);
+        } else if (strcmp(key, "distribution") == 0) {
+            phase->distribution = value;
+            ok = (strcmp(value, "sequential") == 0 || strcmp(value, "uniform") == 0 || strcmp(value, "zipfian") == 0
+                || strcmp(value, "scrambled") == 0 || strcmp(value, "hotspot") == 0 || strcmp(value, "exponential") == 0);
+        } else if (strcmp(key, "hot_set_fraction") == 0) {
+            ok = ParseFraction(value, &phase->hot_set_fraction);
+        } else if (strcmp(key, "hot_op_fraction") == 0) {
+            ok = ParseFraction(value, &phase->hot_op_fraction);
+        } else if (strcmp(key, "arrival") == 0) {
+            phase->arrival = Arrival::Parse(value);
+            ok = (phase->arrival >= 0);
+        } else if (strcmp(key, "keys") == 0) {
+            field = &phase->num_keys;
+        } else if (strcmp(key, "ops") == 0) {
+            field = &phase->num_ops;
+        } else if (strcmp(key, "duration") == 0) {
+            field = &phase->duration;
+        } else if (strcmp(key, "rate") == 0) {
+            field = &phase->target_qps;
+        } else if (strcmp(key, "value_size") == 0) {
+            ValueSize sizes;
+            std::string reason;
+            if (!sizes.Parse(value, &reason)) {
+                snprintf(message, size, "%s", reason.c_str());
+                return;
+            }
+            phase->value_size = value;
+        } else if (strcmp(key, "key_length") == 0) {
+            size_field = &phase->key_length;
+        } else if (strcmp(key, "scan_range") == 0) {
+            size_field = &phase->scan_range;
+        } else if (strcmp(key, "threads") == 0) {
+            ok = ParseNumber(value, &number);
+            phase->num_thread = (int)number;
+        } else {
+            snprintf(message, size, "unknown key [%s]", key);
+            return;
+        }
+        if (field != nullptr || size_field != nullptr) {
+            ok = ParseNumber(value, &number);
+            if (field != nullptr) {
+                *field = number;
+            } else {
+                *size_field = number;
+            }
+        }
+        if (!ok) {
+            snprintf(message, size, "bad value [%s] for [%s]", value, key);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef INCLUDE_XORSHIFT_H_
+#define INCLUDE_XORSHIFT_H_
+
+#include <stdint.h>
+
+// xorshift64* on a caller-owned state, which must not be 0. Shared by the
+// arrival, key distribution and value size generators.
+static inline uint64_t xorshift_random(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+// Uniform in [0, 1) from the top 53 bits.
+static inline double xorshift_double(uint64_t* state)
+{
+    return (xorshift_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif // INCLUDE_XORSHIFT_H_
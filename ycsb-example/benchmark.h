@@ -1,6 +1,12 @@
 #ifndef INCLUDE_BENCHMARK_H_
 #define INCLUDE_BENCHMARK_H_
 
+#include "arrival.h"
+#include "key_distribution.h"
+#include "thread_placement.h"
+#include "trace.h"
+#include "value_generator.h"
+#include "workload_spec.h"
 #include "workload_leveldb.h"
 #include "workload_ycsb.h"
 #include <stdint.h>
@@ -8,20 +14,26 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define NUM_BENCH_THREAD (16)
+#include <atomic>
+#include <vector>
+
 #define BENCH_YCSB (1)
 #define BENCH_LEVELDB (2)
 
 #define OPT_KEY_LENGTH (8)
 #define OPT_VALUE_LENGTH (256)
 #define OPT_MAX_VALUE_LENGTH (4096)
+// largest value a value-size distribution may draw
+#define OPT_MAX_VALUE_SIZE (1 << 20)
 
-#define OPT_TYPE_COUNT (5)
+#define OPT_TYPE_COUNT (6)
 #define OPT_PUT (0)
 #define OPT_UPDATE (1)
 #define OPT_GET (2)
 #define OPT_DELETE (3)
 #define OPT_SCAN (4)
+// read-modify-write, a Get and a Put of the same key timed as one op
+#define OPT_RMW (5)
 
 #define YCSB_ZIPFAN (1)
 // YCSB-A: 50% updates, 50% reads
@@ -32,7 +44,7 @@
 #define YCSB_C (2 << 1)
 // YCSB-E: 5% updates, 95% scans (50 items)
 #define YCSB_E (3 << 1)
-// YCSB-D: 5% updates, 95% lastest-reads
+// YCSB-D: 5% inserts, 95% latest-reads
 #define YCSB_D (4 << 1)
 // YCSB-F: 50% read-modify-write, 50% reads
 #define YCSB_F (5 << 1)
@@ -41,10 +53,46 @@
 // SEQ load
 #define YCSB_SEQ_LOAD (7 << 1)
 
+// replay a trace as fast as the engine takes it
+#define TRACE_TIMING_FAST (0)
+// replay every request at its offset in the trace
+#define TRACE_TIMING_ORIGINAL (1)
+
+// Generator state of one thread, cache-line aligned so threads never share a line.
+struct alignas(CACHE_LINE_SIZE) bench_thread_t {
+    char* key;
+    char* val;
+    int pos;
+    uint64_t opt_sum;
+    uint64_t opt_count[OPT_TYPE_COUNT];
+    uint64_t done_opt_count[OPT_TYPE_COUNT];
+    Random* random[OPT_TYPE_COUNT];
+    uint64_t rng; // state of the KeyDistribution draws of the thread
+    ValueGenerator* values; // nullptr leaves the value bytes as allocated
+};
+
+template <typename T>
+static inline T* new_bench_threads_of(int num_thread)
+{
+    T* threads;
+    if (posix_memalign((void**)&threads, CACHE_LINE_SIZE, num_thread * sizeof(T)) != 0) {
+        return nullptr;
+    }
+    memset(threads, 0, num_thread * sizeof(T));
+    return threads;
+}
+
+static inline bench_thread_t* new_bench_threads(int num_thread)
+{
+    return new_bench_threads_of<bench_thread_t>(num_thread);
+}
+
 class Benchmark {
 public:
     virtual int get_kv_item(int thread_id, uint8_t** key, size_t& key_length, uint8_t** value, size_t& value_length) = 0;
-    virtual void init_thread() = 0;
+    // Called by every worker (after it is bound to its CPUs) before its first
+    // get_kv_item(), so its buffers are allocated on its local node.
+    virtual void init_thread(int thread_id) = 0;
     virtual void print() = 0;
 };
 
@@ -55,35 +103,70 @@ public:
         , num_thread(num_thread)
         , num_item(num_item)
         , seq_id(1)
+        , insert_frontier(num_item)
+        , latest(nullptr)
+        , value_size(nullptr)
+        , compression_ratio(0)
     {
-        init_zipf_generator(0, num_item - 1);
         each_thread_opt = num_opt / num_thread;
         zipfian = (type & YCSB_ZIPFAN) ? 1 : 0;
-        memset(opt_sum, 0, sizeof(opt_sum));
-        memset(opt_count, 0, sizeof(opt_count));
-
-        for (int i = 0; i < NUM_BENCH_THREAD; i++) {
-            key_[i] = new char[OPT_KEY_LENGTH];
-            val_[i] = new char[OPT_MAX_VALUE_LENGTH];
+        key_distribution = new KeyDistribution(zipfian ? DIST_ZIPFIAN : DIST_UNIFORM, num_item);
+        if (this->type == YCSB_D) {
+            latest = new KeyDistribution(DIST_ZIPFIAN, num_item);
         }
+        threads = new_bench_threads(num_thread);
+    }
+
+    // Replaces the uniform/zipfian choice of the type (DIST_*), YCSB-D keeps
+    // reading the latest keys. Call before the first init_thread().
+    void SetKeyDistribution(int distribution, double hot_set_fraction, double hot_op_fraction)
+    {
+        delete key_distribution;
+        key_distribution = new KeyDistribution(distribution, num_item, hot_set_fraction, hot_op_fraction);
+    }
+
+    // Draws every value length from value_size (nullptr keeps OPT_MAX_VALUE_LENGTH)
+    // and, with compression_ratio > 0, cuts written values from a pool that
+    // compresses to about that ratio. Call before the first init_thread().
+    void SetValueSize(const ValueSize* value_size, double compression_ratio)
+    {
+        this->value_size = value_size;
+        this->compression_ratio = compression_ratio;
     }
 
     ~YCSB_Benchmark()
     {
+        delete key_distribution;
+        delete latest;
+        for (int i = 0; i < num_thread; i++) {
+            delete[] threads[i].key;
+            delete[] threads[i].val;
+            delete threads[i].values;
+        }
+        free(threads);
     }
 
-    void init_thread()
+    void init_thread(int thread_id)
     {
-        init_seed();
+        size_t value_capacity = (value_size != nullptr) ? value_size->Max() : OPT_MAX_VALUE_LENGTH;
+        threads[thread_id].rng = KeyDistribution::Seed(((uint64_t)type << 32) + thread_id);
+        threads[thread_id].key = new char[OPT_KEY_LENGTH];
+        threads[thread_id].val = new char[value_capacity];
+        if (compression_ratio > 0) {
+            threads[thread_id].values = new ValueGenerator(compression_ratio, threads[thread_id].rng, value_capacity);
+        }
     }
 
     void print()
     {
-        printf(">>[YCSB-Benchmark]\n");
+        printf(">>[YCSB-Benchmark][KEYS:%s]\n", (type == YCSB_D) ? "latest" : KeyDistribution::Name(key_distribution->Type()));
         for (int i = 0; i < num_thread; i++) {
-            printf("  [%d][PUT:%llu][UPDATE:%llu][GET:%llu][DELETE:%llu][SCAN:%llu]\n",
-                i, opt_count[i][OPT_PUT], opt_count[i][OPT_UPDATE], opt_count[i][OPT_GET],
-                opt_count[i][OPT_DELETE], opt_count[i][OPT_SCAN]);
+            printf("  [%d][PUT:%llu][UPDATE:%llu][GET:%llu][DELETE:%llu][SCAN:%llu][RMW:%llu]\n",
+                i, threads[i].opt_count[OPT_PUT], threads[i].opt_count[OPT_UPDATE], threads[i].opt_count[OPT_GET],
+                threads[i].opt_count[OPT_DELETE], threads[i].opt_count[OPT_SCAN], threads[i].opt_count[OPT_RMW]);
+        }
+        if (type == YCSB_D) {
+            printf("  [INSERTED:%llu][FRONTIER:%llu]\n", (unsigned long long)(insert_frontier.load() - num_item), (unsigned long long)insert_frontier.load());
         }
     }
 
@@ -91,80 +174,94 @@ public:
     int get_kv_item(int thread_id, uint8_t** key, size_t& key_length, uint8_t** value, size_t& value_length)
     {
         int opt_type;
-        opt_sum[thread_id]++;
+        uint64_t* opt_count = threads[thread_id].opt_count;
+        threads[thread_id].opt_sum++;
         key_length = OPT_KEY_LENGTH;
-        if (opt_sum[thread_id] > each_thread_opt) {
+        if (threads[thread_id].opt_sum > each_thread_opt) {
             return -1;
         }
         if (type == YCSB_SEQ_LOAD) {
             value_length = generate_kv_pair(thread_id, seq_id++, num_item);
-            opt_count[thread_id][OPT_PUT]++;
+            opt_count[OPT_PUT]++;
             opt_type = OPT_PUT;
         } else if (type == YCSB_LOAD) {
-            if (zipfian) { // zipf skew
-                value_length = generate_kv_pair(thread_id, zipf_next(), num_item);
-            } else { // uniform skew
-                value_length = generate_kv_pair(thread_id, uniform_next(), num_item);
-            }
-            opt_count[thread_id][OPT_PUT]++;
+            value_length = generate_kv_pair(thread_id, key_distribution->Next(&threads[thread_id].rng), num_item);
+            opt_count[OPT_PUT]++;
             opt_type = OPT_PUT;
         } else if (type == YCSB_A || type == YCSB_B || type == YCSB_C) { // ycsb-a, ycsb-b, ycsb-c
-            if (zipfian) { // zipf skew
-                value_length = generate_kv_pair(thread_id, zipf_next(), num_item);
-            } else { // uniform skew
-                value_length = generate_kv_pair(thread_id, uniform_next(), num_item);
-            }
-            if (random_get_put(type)) {
-                opt_count[thread_id][OPT_UPDATE]++; // update
+            value_length = generate_kv_pair(thread_id, key_distribution->Next(&threads[thread_id].rng), num_item);
+            if (random_get_put(thread_id, type)) {
+                opt_count[OPT_UPDATE]++; // update
                 opt_type = OPT_UPDATE;
             } else {
-                opt_count[thread_id][OPT_GET]++; // scan
+                opt_count[OPT_GET]++; // scan
                 opt_type = OPT_GET;
             }
         } else if (type == YCSB_E) { // ycsb-e
-            if (zipfian) { // zipf skew
-                value_length = generate_kv_pair(thread_id, zipf_next(), num_item);
-            } else { // uniform skew
-                value_length = generate_kv_pair(thread_id, uniform_next(), num_item);
-            }
-            if (random_get_put(type)) {
-                opt_count[thread_id][OPT_UPDATE]++; // update
+            value_length = generate_kv_pair(thread_id, key_distribution->Next(&threads[thread_id].rng), num_item);
+            if (random_get_put(thread_id, type)) {
+                opt_count[OPT_UPDATE]++; // update
                 opt_type = OPT_UPDATE;
             } else {
-                opt_count[thread_id][OPT_SCAN]++; // get
+                opt_count[OPT_SCAN]++; // get
                 opt_type = OPT_SCAN;
             }
-        } else { // ycsb-d, ycsb-f
+        } else if (type == YCSB_D) { // ycsb-d
+            if (random_get_put(thread_id, type)) {
+                // new keys extend the loaded range, ids are handed out once across threads.
+                value_length = generate_kv_pair(thread_id, insert_frontier.fetch_add(1) + 1, num_item);
+                opt_count[OPT_PUT]++;
+                opt_type = OPT_PUT;
+            } else {
+                value_length = generate_kv_pair(thread_id, latest_next(thread_id), num_item);
+                opt_count[OPT_GET]++;
+                opt_type = OPT_GET;
+            }
+        } else if (type == YCSB_F) { // ycsb-f
+            value_length = generate_kv_pair(thread_id, key_distribution->Next(&threads[thread_id].rng), num_item);
+            if (random_get_put(thread_id, type)) {
+                opt_count[OPT_RMW]++;
+                opt_type = OPT_RMW;
+            } else {
+                opt_count[OPT_GET]++;
+                opt_type = OPT_GET;
+            }
+        } else {
             opt_type = -1;
         }
-        *key = (uint8_t*)key_[thread_id];
-        *value = (uint8_t*)val_[thread_id];
+        if (threads[thread_id].values != nullptr && (opt_type == OPT_PUT || opt_type == OPT_UPDATE || opt_type == OPT_RMW)) {
+            // only written values need fresh bytes, the key stays stamped in front.
+            memcpy(threads[thread_id].val, threads[thread_id].values->Generate(value_length), value_length);
+            memcpy(threads[thread_id].val, threads[thread_id].key, OPT_KEY_LENGTH);
+        }
+        *key = (uint8_t*)threads[thread_id].key;
+        *value = (uint8_t*)threads[thread_id].val;
         return opt_type;
     }
 
 private:
+    // Zipfian over the distance to the newest key (YCSB's skewed-latest): the
+    // most recent inserts of any thread are the hottest. The key of an insert
+    // still in flight on another thread may be read before it is written.
+    uint64_t latest_next(int thread_id)
+    {
+        uint64_t frontier = insert_frontier.load(std::memory_order_relaxed);
+        uint64_t distance = latest->Next(&threads[thread_id].rng);
+        return (distance < frontier) ? frontier - distance : 1;
+    }
+
     size_t generate_kv_pair(int thread_id, uint64_t uid, uint64_t max_uid)
     {
-        size_t item_size;
-        if (uid * 100LU / max_uid < 50) {
-            // item_size = 256;
-            item_size = 4096;
-        } else if (uid * 100LU / max_uid < 82) {
-            item_size = 4096;
-        } else if (uid * 100LU / max_uid < 98) {
-            item_size = 4096;
-        } else {
-            item_size = 4096;
-        }
+        size_t item_size = (value_size != nullptr) ? value_size->Next(&threads[thread_id].rng) : OPT_MAX_VALUE_LENGTH;
 
-        *((uint64_t*)key_[thread_id]) = uid;
-        *((uint64_t*)val_[thread_id]) = uid;
+        *((uint64_t*)threads[thread_id].key) = uid;
+        *((uint64_t*)threads[thread_id].val) = uid;
         return item_size;
     }
 
-    int random_get_put(int test)
+    int random_get_put(int thread_id, int test)
     {
-        long random = uniform_next() % 100;
+        long random = xorshift_random(&threads[thread_id].rng) % 100;
         switch (test) {
         case YCSB_LOAD:
             return 1;
@@ -176,6 +273,10 @@ private:
             return 0;
         case YCSB_E: // E
             return random >= 95;
+        case YCSB_D: // D
+            return random >= 95;
+        case YCSB_F: // F
+            return random >= 50;
         default:
             return 0;
         }
@@ -183,6 +284,11 @@ private:
 
 private:
     uint64_t seq_id;
+    std::atomic<uint64_t> insert_frontier; // newest key of YCSB-D, the load ends at num_item
+    KeyDistribution* key_distribution; // shared, read-only while threads draw from it
+    KeyDistribution* latest; // distance from the frontier, YCSB-D only
+    const ValueSize* value_size; // shared like the key distribution, nullptr is fixed
+    double compression_ratio;
 
 private:
     int type;
@@ -192,12 +298,7 @@ private:
     uint64_t num_item;
 
 private:
-    char* key_[NUM_BENCH_THREAD];
-    char* val_[NUM_BENCH_THREAD];
-
-private:
-    uint64_t opt_sum[NUM_BENCH_THREAD];
-    uint64_t opt_count[NUM_BENCH_THREAD][OPT_TYPE_COUNT];
+    bench_thread_t* threads; // [num_thread]
 };
 
 class Mirco_Benchmark : public Benchmark {
@@ -206,39 +307,42 @@ public:
         : num_thread(num_thread)
         , seq(1)
     {
-        for (int i = 0; i < NUM_BENCH_THREAD; i++) {
-            key_[i] = new char[OPT_KEY_LENGTH];
-            val_[i] = new char[OPT_MAX_VALUE_LENGTH];
-        }
+        memset(seed, 0, sizeof(seed));
+        memset(each_thread_opt, 0, sizeof(each_thread_opt));
+        threads = new_bench_threads(num_thread);
     }
 
     Mirco_Benchmark(int num_thread, int seed_[OPT_TYPE_COUNT], uint64_t num_opt[OPT_TYPE_COUNT], uint64_t scan_range)
-        : pos(0)
-        , num_thread(num_thread)
+        : num_thread(num_thread)
         , scan_range(scan_range)
     {
-        for (int i = 0; i < NUM_BENCH_THREAD; i++) {
-            key_[i] = new char[OPT_KEY_LENGTH];
-            val_[i] = new char[OPT_MAX_VALUE_LENGTH];
-        }
         for (int i = 0; i < OPT_TYPE_COUNT; i++) {
             each_thread_opt[i] = num_opt[i] / num_thread; // average for each thread.
             seed[i] = seed_[i];
         }
-        for (int i = 0; i < NUM_BENCH_THREAD; i++) {
-            for (int j = 0; j < OPT_TYPE_COUNT; j++) {
-                random[i][j] = generate_random(0, seed[j] + i);
-                done_opt_count[i][j] = 0;
-            }
-        }
+        threads = new_bench_threads(num_thread);
     }
 
     ~Mirco_Benchmark()
     {
+        for (int i = 0; i < num_thread; i++) {
+            delete[] threads[i].key;
+            delete[] threads[i].val;
+            for (int j = 0; j < OPT_TYPE_COUNT; j++) {
+                delete threads[i].random[j];
+            }
+        }
+        free(threads);
     }
 
-    void init_thread()
+    void init_thread(int thread_id)
     {
+        bench_thread_t* t = &threads[thread_id];
+        t->key = new char[OPT_KEY_LENGTH];
+        t->val = new char[OPT_MAX_VALUE_LENGTH];
+        for (int j = 0; j < OPT_TYPE_COUNT; j++) {
+            t->random[j] = generate_random(0, seed[j] + thread_id);
+        }
     }
 
     void print()
@@ -248,13 +352,15 @@ public:
 public:
     int get_kv_item(int thread_id, uint8_t** key, size_t& key_length, uint8_t** value, size_t& value_length)
     {
+        bench_thread_t* t = &threads[thread_id];
+        int& pos = t->pos;
         int mark = pos;
         while (true) {
-            if (done_opt_count[thread_id][pos] < each_thread_opt[pos]) {
-                done_opt_count[thread_id][pos]++;
-                generate_kv_pair(thread_id, random[thread_id][pos]);
-                *key = (uint8_t*)key_[thread_id];
-                *value = (uint8_t*)val_[thread_id];
+            if (t->done_opt_count[pos] < each_thread_opt[pos]) {
+                t->done_opt_count[pos]++;
+                generate_kv_pair(thread_id, t->random[pos]);
+                *key = (uint8_t*)t->key;
+                *value = (uint8_t*)t->val;
                 key_length = OPT_KEY_LENGTH;
                 value_length = OPT_VALUE_LENGTH;
                 break;
@@ -280,23 +386,360 @@ private:
     void generate_kv_pair(int thread_id, Random* rd)
     {
         uint64_t seed = rd->Next();
-        *((uint64_t*)key_[thread_id]) = seed;
-        *((uint64_t*)val_[thread_id]) = seed;
+        *((uint64_t*)threads[thread_id].key) = seed;
+        *((uint64_t*)threads[thread_id].val) = seed;
     }
 
 private:
-    int pos;
     int seq;
     int num_thread;
     uint64_t scan_range;
     int seed[OPT_TYPE_COUNT]; // seed for each operation
     uint64_t each_thread_opt[OPT_TYPE_COUNT]; // sum operation count
-    uint64_t done_opt_count[OPT_TYPE_COUNT][OPT_TYPE_COUNT]; // has done for each operation
-    Random* random[NUM_BENCH_THREAD][OPT_TYPE_COUNT];
 
 private:
-    char* key_[NUM_BENCH_THREAD];
-    char* val_[NUM_BENCH_THREAD];
+    bench_thread_t* threads; // [num_thread], pos/done_opt_count/random per thread
+};
+
+// Replay state of one thread.
+struct alignas(CACHE_LINE_SIZE) trace_thread_t {
+    char* key;
+    char* val;
+    uint64_t next; // index of the thread's next record in its partition
+    uint64_t trace_ns; // trace time of the last record handed out
+    uint64_t opt_count[TRACE_OP_COUNT];
+    uint64_t sum_late_ns;
+    uint64_t max_late_ns;
+};
+
+// Replays a trace written by TraceRecorder. Thread t takes, in trace order, the
+// records whose key hashes to t, so the requests to one key keep their order.
+// The trace is partitioned once when it is loaded: every thread gets the
+// offsets of its records in the mmap'ed file and their absolute trace times,
+// so a thread only touches its own records. With TRACE_TIMING_ORIGINAL a
+// request is not handed out before its offset in the trace, counted from the
+// first get_kv_item() of any thread, has passed.
+class TraceReplay_Benchmark : public Benchmark {
+public:
+    TraceReplay_Benchmark(const char* path, int num_thread, int timing)
+        : num_thread(num_thread)
+        , timing(timing)
+        , start_ns(0)
+    {
+        valid = reader.Open(path);
+        threads = new_bench_threads_of<trace_thread_t>(num_thread);
+        partitions.resize(num_thread);
+        if (valid) {
+            Partition();
+        }
+    }
+
+    ~TraceReplay_Benchmark()
+    {
+        for (int i = 0; i < num_thread; i++) {
+            delete[] threads[i].key;
+            delete[] threads[i].val;
+        }
+        free(threads);
+    }
+
+    // false if the trace could not be mapped or is not a trace.
+    bool Valid(void) const
+    {
+        return valid;
+    }
+
+    const trace_header_t* Header(void) const
+    {
+        return reader.Header();
+    }
+
+    void init_thread(int thread_id)
+    {
+        trace_thread_t* t = &threads[thread_id];
+        size_t value_size = reader.Header()->max_value_length + 1;
+        t->key = new char[TRACE_MAX_KEY_LENGTH + 1];
+        t->val = new char[value_size];
+        memset(t->val, 'v', value_size);
+        t->next = 0;
+    }
+
+    void print()
+    {
+        const trace_header_t* header = reader.Header();
+        printf(">>[Trace-Replay][RECORDS:%llu][DURATION:%.3fs][TIMING:%s]\n", (unsigned long long)header->num_record, header->duration_ns / 1000000000.0,
+            (timing == TRACE_TIMING_ORIGINAL) ? "original" : "fast");
+        for (int i = 0; i < num_thread; i++) {
+            trace_thread_t* t = &threads[i];
+            uint64_t count = 0;
+            for (int j = 0; j < TRACE_OP_COUNT; j++) {
+                count += t->opt_count[j];
+            }
+            printf("  [%d][PUT:%llu][GET:%llu][DELETE:%llu][SCAN:%llu]", i, (unsigned long long)t->opt_count[TRACE_PUT],
+                (unsigned long long)t->opt_count[TRACE_GET], (unsigned long long)t->opt_count[TRACE_DELETE], (unsigned long long)t->opt_count[TRACE_SCAN]);
+            if (timing == TRACE_TIMING_ORIGINAL && count > 0) {
+                printf("[LATE avg:%lluns max:%lluns]", (unsigned long long)(t->sum_late_ns / count), (unsigned long long)t->max_late_ns);
+            }
+            printf("\n");
+        }
+    }
+
+public:
+    int get_kv_item(int thread_id, uint8_t** key, size_t& key_length, uint8_t** value, size_t& value_length)
+    {
+        trace_thread_t* t = &threads[thread_id];
+        const std::vector<trace_entry_t>& entries = partitions[thread_id];
+        if (t->next >= entries.size()) {
+            return -1;
+        }
+        const trace_entry_t& entry = entries[t->next++];
+        uint64_t offset = entry.offset;
+        const char* record_key;
+        const trace_record_t* record = reader.Next(&offset, &record_key);
+        t->trace_ns = entry.trace_ns;
+        if (timing == TRACE_TIMING_ORIGINAL) {
+            uint64_t start = start_ns.load(std::memory_order_relaxed);
+            if (start == 0) {
+                uint64_t now = Arrival::Now();
+                start = start_ns.compare_exchange_strong(start, now) ? now : start;
+            }
+            uint64_t late_ns = Arrival::WaitUntil(start + t->trace_ns);
+            t->sum_late_ns += late_ns;
+            t->max_late_ns = (late_ns > t->max_late_ns) ? late_ns : t->max_late_ns;
+        }
+        memcpy(t->key, record_key, record->key_length);
+        key_length = record->key_length;
+        // the scan range of a record is not a value, scans use the workload's range.
+        value_length = (record->op == TRACE_PUT) ? record->value_length : 0;
+        t->opt_count[record->op]++;
+        *key = (uint8_t*)t->key;
+        *value = (uint8_t*)t->val;
+        switch (record->op) {
+        case TRACE_PUT:
+            return OPT_PUT;
+        case TRACE_GET:
+            return OPT_GET;
+        case TRACE_DELETE:
+            return OPT_DELETE;
+        default:
+            return OPT_SCAN;
+        }
+    }
+
+private:
+    struct trace_entry_t {
+        uint64_t offset; // of the record in the trace
+        uint64_t trace_ns; // its time since the start of the trace
+    };
+
+    // One pass over the trace, records of unknown ops only advance the clock.
+    void Partition(void)
+    {
+        uint64_t offset = reader.Begin();
+        uint64_t trace_ns = 0;
+        const char* record_key;
+        while (true) {
+            trace_entry_t entry;
+            entry.offset = offset;
+            const trace_record_t* record = reader.Next(&offset, &record_key);
+            if (record == nullptr) {
+                break;
+            }
+            trace_ns += record->delta_ns;
+            if (record->op >= TRACE_OP_COUNT) {
+                continue;
+            }
+            entry.trace_ns = trace_ns;
+            int owner = (num_thread == 1) ? 0 : (int)(trace_key_hash(record_key, record->key_length) % num_thread);
+            partitions[owner].push_back(entry);
+        }
+    }
+
+private:
+    int num_thread;
+    int timing;
+    bool valid;
+    TraceReader reader;
+    std::atomic<uint64_t> start_ns; // trace time 0, set by the first request
+    std::vector<std::vector<trace_entry_t> > partitions; // [num_thread], built by Partition()
+
+private:
+    trace_thread_t* threads; // [num_thread]
+};
+
+// Generator state of one thread of a spec phase.
+struct alignas(CACHE_LINE_SIZE) spec_thread_t {
+    char* key;
+    char* val;
+    uint64_t rng;
+    uint64_t opt_sum;
+    uint64_t next_seq; // sequential: next key of the thread's slice
+    uint64_t opt_count[OPT_TYPE_COUNT];
+    ValueGenerator* values; // nullptr leaves the value bytes as allocated
+};
+
+// Runs one phase of a workload spec (workload_spec.h). Every op is drawn from
+// the mix with the thread's own random state. Reads, updates and RMWs take
+// their keys from the phase distribution over [0, keys), puts insert new keys
+// past it. With the sequential distribution every thread writes (or reads) its
+// own slice of [0, keys) in order, which is how a load phase fills the store.
+// Written values take their length from the phase's value_size and, with a
+// compression_ratio > 0, their bytes from a ValueGenerator.
+class Spec_Benchmark : public Benchmark {
+public:
+    Spec_Benchmark(const phase_spec_t* phase, int num_thread, double compression_ratio = 0)
+        : name(phase->name)
+        , num_thread(num_thread)
+        , num_keys(phase->num_keys > 0 ? phase->num_keys : 1)
+        , compression_ratio(compression_ratio)
+        , duration_ns(phase->duration * 1000000000)
+        , sequential(phase->distribution == "sequential")
+        , key_distribution(nullptr)
+        , insert_frontier(num_keys)
+        , start_ns(0)
+    {
+        // spec ops run as the driver's own op types, multiget has no driver op here.
+        static const int opt_of[SPEC_OP_COUNT] = { OPT_PUT, OPT_UPDATE, OPT_GET, OPT_DELETE, OPT_SCAN, OPT_RMW, -1 };
+        double total = 0;
+        for (int i = 0; i < SPEC_OP_COUNT; i++) {
+            total += (opt_of[i] >= 0) ? phase->mix[i] : 0;
+        }
+        num_mix = 0;
+        double sum = 0;
+        for (int i = 0; i < SPEC_OP_COUNT; i++) {
+            if (opt_of[i] >= 0 && phase->mix[i] > 0) {
+                sum += phase->mix[i];
+                mix_opt[num_mix] = opt_of[i];
+                mix_bound[num_mix] = sum / total;
+                num_mix++;
+            }
+        }
+        if (!sequential) {
+            key_distribution = new KeyDistribution(KeyDistribution::Parse(phase->distribution.c_str()), num_keys,
+                phase->hot_set_fraction, phase->hot_op_fraction);
+        }
+        std::string error;
+        value_size.Parse(phase->value_size.c_str(), &error); // checked by WorkloadSpec::Load
+        value_size.Clamp(OPT_KEY_LENGTH, OPT_MAX_VALUE_SIZE);
+        each_thread_opt = (duration_ns > 0) ? UINT64_MAX : phase->NumOps() / num_thread;
+        threads = new_bench_threads_of<spec_thread_t>(num_thread);
+    }
+
+    ~Spec_Benchmark()
+    {
+        for (int i = 0; i < num_thread; i++) {
+            delete[] threads[i].key;
+            delete[] threads[i].val;
+            delete threads[i].values;
+        }
+        free(threads);
+        delete key_distribution;
+    }
+
+    // false if no op of the mix runs in this driver.
+    bool Valid(void) const
+    {
+        return num_mix > 0;
+    }
+
+    void init_thread(int thread_id)
+    {
+        spec_thread_t* t = &threads[thread_id];
+        t->rng = KeyDistribution::Seed(((uint64_t)thread_id << 32) + std::hash<std::string>()(name));
+        t->next_seq = num_keys * thread_id / num_thread;
+        t->key = new char[OPT_KEY_LENGTH];
+        t->val = new char[value_size.Max()];
+        memset(t->val, 'v', value_size.Max());
+        if (compression_ratio > 0) {
+            t->values = new ValueGenerator(compression_ratio, t->rng, value_size.Max());
+        }
+    }
+
+    void print()
+    {
+        printf(">>[Spec-Benchmark][PHASE:%s][KEYS:%s][VALUES:%s]\n", name.c_str(),
+            sequential ? "sequential" : KeyDistribution::Name(key_distribution->Type()), value_size.ToString());
+        for (int i = 0; i < num_thread; i++) {
+            uint64_t* opt_count = threads[i].opt_count;
+            printf("  [%d][PUT:%llu][UPDATE:%llu][GET:%llu][DELETE:%llu][SCAN:%llu][RMW:%llu]\n", i, (unsigned long long)opt_count[OPT_PUT],
+                (unsigned long long)opt_count[OPT_UPDATE], (unsigned long long)opt_count[OPT_GET], (unsigned long long)opt_count[OPT_DELETE],
+                (unsigned long long)opt_count[OPT_SCAN], (unsigned long long)opt_count[OPT_RMW]);
+        }
+    }
+
+public:
+    int get_kv_item(int thread_id, uint8_t** key, size_t& key_length, uint8_t** value, size_t& value_length)
+    {
+        spec_thread_t* t = &threads[thread_id];
+        if (++t->opt_sum > each_thread_opt || Expired()) {
+            return -1;
+        }
+        double u = xorshift_double(&t->rng);
+        int i = 0;
+        while (i < num_mix - 1 && u >= mix_bound[i]) {
+            i++;
+        }
+        int opt_type = mix_opt[i];
+
+        uint64_t uid;
+        if (sequential) {
+            uint64_t end = num_keys * (thread_id + 1) / num_thread;
+            if (t->next_seq >= end) {
+                t->next_seq = num_keys * thread_id / num_thread; // wrap around the slice
+            }
+            uid = t->next_seq++;
+        } else if (opt_type == OPT_PUT) {
+            uid = insert_frontier.fetch_add(1);
+        } else {
+            uid = key_distribution->Next(&t->rng);
+        }
+        value_length = value_size.Next(&t->rng);
+        if (t->values != nullptr && (opt_type == OPT_PUT || opt_type == OPT_UPDATE || opt_type == OPT_RMW)) {
+            memcpy(t->val, t->values->Generate(value_length), value_length);
+        }
+        *((uint64_t*)t->key) = uid;
+        *((uint64_t*)t->val) = uid;
+        t->opt_count[opt_type]++;
+        key_length = OPT_KEY_LENGTH;
+        *key = (uint8_t*)t->key;
+        *value = (uint8_t*)t->val;
+        return opt_type;
+    }
+
+private:
+    // A phase with a duration ends for all threads at the same time, counted
+    // from its first op.
+    bool Expired(void)
+    {
+        if (duration_ns == 0) {
+            return false;
+        }
+        uint64_t now = Arrival::Now();
+        uint64_t start = start_ns.load(std::memory_order_relaxed);
+        if (start == 0) {
+            start = start_ns.compare_exchange_strong(start, now) ? now : start;
+        }
+        return now - start >= duration_ns;
+    }
+
+private:
+    std::string name;
+    int num_thread;
+    uint64_t num_keys;
+    ValueSize value_size;
+    double compression_ratio;
+    uint64_t duration_ns;
+    uint64_t each_thread_opt;
+    bool sequential;
+    int num_mix;
+    int mix_opt[SPEC_OP_COUNT];
+    double mix_bound[SPEC_OP_COUNT]; // cumulative share of the mix
+    KeyDistribution* key_distribution; // nullptr when sequential
+    std::atomic<uint64_t> insert_frontier;
+    std::atomic<uint64_t> start_ns;
+
+private:
+    spec_thread_t* threads; // [num_thread]
 };
 
 #endif
\ No newline at end of file
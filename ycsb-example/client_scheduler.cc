@@ -0,0 +1,61 @@
+#include "client_scheduler.h"
+#include "arrival.h"
+
+ClientScheduler::ClientScheduler()
+    : now_ns(0)
+    , seq(0)
+    , num_live(0)
+{
+}
+
+ClientScheduler::~ClientScheduler()
+{
+    for (size_t i = 0; i < clients.size(); i++) {
+        clients[i].destroy();
+    }
+}
+
+void ClientScheduler::Spawn(ClientTask task)
+{
+    clients.push_back(task.handle);
+    ready.push_back(task.handle);
+    num_live++;
+}
+
+void ClientScheduler::Suspend(std::coroutine_handle<> handle, uint64_t wake_ns)
+{
+    if (wake_ns <= now_ns) {
+        ready.push_back(handle);
+    } else {
+        timers.push(timer_entry_t { wake_ns, seq++, handle });
+    }
+}
+
+void ClientScheduler::Run(void)
+{
+    while (num_live > 0) {
+        now_ns = Arrival::Now();
+        while (!timers.empty() && timers.top().wake_ns <= now_ns) {
+            ready.push_back(timers.top().handle);
+            timers.pop();
+        }
+        if (ready.empty()) {
+            // every client is waiting, sleep (then spin) until the first one wakes.
+            uint64_t wake_ns = timers.top().wake_ns;
+            if (wake_ns - now_ns > ARRIVAL_SPIN_NS) {
+                uint64_t sleep_ns = wake_ns - now_ns - ARRIVAL_SPIN_NS;
+                struct timespec ts;
+                ts.tv_sec = sleep_ns / 1000000000;
+                ts.tv_nsec = sleep_ns % 1000000000;
+                nanosleep(&ts, NULL);
+            }
+            continue;
+        }
+        std::coroutine_handle<> handle = ready.front();
+        ready.pop_front();
+        handle.resume();
+        if (handle.done()) {
+            num_live--;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef INCLUDE_CLIENT_SCHEDULER_H_
+#define INCLUDE_CLIENT_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Coroutine of one simulated client. It is created suspended and only runs
+// inside ClientScheduler::Run(), which owns it after Spawn().
+class ClientTask {
+public:
+    struct promise_type {
+        ClientTask get_return_object()
+        {
+            return ClientTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+    explicit ClientTask(std::coroutine_handle<promise_type> handle)
+        : handle(handle)
+    {
+    }
+
+    std::coroutine_handle<> handle;
+};
+
+// Multiplexes many client coroutines on the calling thread, like a server event
+// loop serving many connections per core. Clients only give up the thread at
+// co_await SleepUntil(), so everything between two suspensions runs without
+// interruption and needs no locking. Ready clients run in FIFO order.
+class ClientScheduler {
+public:
+    struct sleep_t {
+        ClientScheduler* scheduler;
+        uint64_t wake_ns;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            scheduler->Suspend(handle, wake_ns);
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    ClientScheduler();
+    ~ClientScheduler();
+
+    void Spawn(ClientTask task);
+
+    // Suspends the client until wake_ns (Arrival::Now() clock). A time that has
+    // passed still yields, the client goes behind the other ready clients.
+    sleep_t SleepUntil(uint64_t wake_ns)
+    {
+        return sleep_t { this, wake_ns };
+    }
+
+    // Runs until every spawned client has returned.
+    void Run(void);
+
+    size_t NumClient(void) const
+    {
+        return clients.size();
+    }
+
+private:
+    struct timer_entry_t {
+        uint64_t wake_ns;
+        uint64_t seq; // clients waking at the same time keep their order
+        std::coroutine_handle<> handle;
+
+        bool operator>(const timer_entry_t& other) const
+        {
+            return wake_ns > other.wake_ns || (wake_ns == other.wake_ns && seq > other.seq);
+        }
+    };
+
+    void Suspend(std::coroutine_handle<> handle, uint64_t wake_ns);
+
+private:
+    uint64_t now_ns; // read once per resumed client
+    uint64_t seq;
+    size_t num_live;
+    std::vector<std::coroutine_handle<> > clients;
+    std::deque<std::coroutine_handle<> > ready;
+    std::priority_queue<timer_entry_t, std::vector<timer_entry_t>, std::greater<timer_entry_t> > timers;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "executor_pool.h"
+
+#include <unistd.h>
+
+ExecutorPool::ExecutorPool(int num_executor, const ThreadPlacement* client_placement, int num_client_thread)
+    : num_executor(num_executor)
+    , client_placement(nullptr)
+    , first_slot(0)
+    , num_free_slot(0)
+{
+    if (this->num_executor <= 0) {
+        this->num_executor = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (this->num_executor <= 0) {
+        this->num_executor = 1;
+    }
+    if (client_placement != nullptr && client_placement->Policy() != PLACEMENT_NONE) {
+        // executors must not share the clients' CPUs, the pipeline would compete with itself.
+        this->client_placement = client_placement;
+        first_slot = num_client_thread;
+        num_free_slot = (client_placement->NumSlot() > num_client_thread) ? client_placement->NumSlot() - num_client_thread : 0;
+    } else if (!placement.Init(PLACEMENT_COMPACT, nullptr)) {
+        placement.Init(PLACEMENT_NONE, nullptr);
+    }
+    executors = new executor_t[this->num_executor];
+    for (int i = 0; i < this->num_executor; i++) {
+        executors[i].pool = this;
+        executors[i].id = i;
+        executors[i].stop = false;
+        pthread_create(&executors[i].thread, NULL, ExecutorMain, &executors[i]);
+    }
+}
+
+ExecutorPool::~ExecutorPool()
+{
+    for (int i = 0; i < num_executor; i++) {
+        std::lock_guard<std::mutex> lock(executors[i].mutex);
+        executors[i].stop = true;
+        executors[i].cond.notify_one();
+    }
+    for (int i = 0; i < num_executor; i++) {
+        pthread_join(executors[i].thread, NULL);
+    }
+    delete[] executors;
+}
+
+void ExecutorPool::Submit(int executor_id, executor_task_t task, void* arg)
+{
+    executor_t* executor = &executors[executor_id % num_executor];
+    executor_task_entry_t entry;
+    entry.task = task;
+    entry.arg = arg;
+    std::lock_guard<std::mutex> lock(executor->mutex);
+    executor->queue.push_back(entry);
+    executor->cond.notify_one();
+}
+
+void* ExecutorPool::ExecutorMain(void* arg)
+{
+    executor_t* executor = (executor_t*)arg;
+    ExecutorPool* pool = executor->pool;
+    if (pool->client_placement == nullptr) {
+        pool->placement.Bind(executor->id);
+    } else if (pool->num_free_slot > 0) {
+        pool->client_placement->Bind(pool->first_slot + executor->id % pool->num_free_slot);
+    }
+
+    std::deque<executor_task_entry_t> tasks;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(executor->mutex);
+            executor->cond.wait(lock, [executor]() {
+                return executor->stop || !executor->queue.empty();
+            });
+            // queued tasks still run after Stop, their submitters wait for them.
+            if (executor->queue.empty()) {
+                break;
+            }
+            tasks.swap(executor->queue);
+        }
+        for (size_t i = 0; i < tasks.size(); i++) {
+            tasks[i].task(tasks[i].arg);
+        }
+        tasks.clear();
+    }
+    return NULL;
+}
@@ -0,0 +1,63 @@
+#ifndef INCLUDE_EXECUTOR_POOL_H_
+#define INCLUDE_EXECUTOR_POOL_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "thread_placement.h"
+
+typedef void (*executor_task_t)(void* arg);
+
+// A fixed set of executor threads, one per core, that run blocking engine calls
+// for client threads which keep several requests in flight. Every executor has
+// its own queue, so submitters spread their requests themselves (Submit() takes
+// the executor id) and executors never steal from each other.
+class ExecutorPool {
+public:
+    // num_executor 0 starts one executor per online CPU. Without a client
+    // placement (nullptr or PLACEMENT_NONE) executors are bound compactly
+    // (physical cores first) when the topology can be read. With one they take
+    // its slots after the num_client_thread ones of the clients, round-robin,
+    // and stay unbound when the clients already use every slot.
+    ExecutorPool(int num_executor, const ThreadPlacement* client_placement, int num_client_thread);
+    ~ExecutorPool();
+
+    void Submit(int executor_id, executor_task_t task, void* arg);
+
+    int NumExecutor(void) const
+    {
+        return num_executor;
+    }
+
+private:
+    struct executor_task_entry_t {
+        executor_task_t task;
+        void* arg;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) executor_t {
+        ExecutorPool* pool;
+        int id;
+        pthread_t thread;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<executor_task_entry_t> queue;
+        bool stop;
+    };
+
+    static void* ExecutorMain(void* arg);
+
+private:
+    int num_executor;
+    executor_t* executors;
+    ThreadPlacement placement; // used when there is no client placement
+    const ThreadPlacement* client_placement;
+    int first_slot; // of client_placement, after the clients
+    int num_free_slot; // 0 leaves executors unbound
+};
+
+#endif
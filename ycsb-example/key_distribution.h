@@ -0,0 +1,179 @@
+#ifndef INCLUDE_KEY_DISTRIBUTION_H_
+#define INCLUDE_KEY_DISTRIBUTION_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "xorshift.h"
+
+#define DIST_UNIFORM (0)
+// YCSB zipfian, rank 0 (the lowest key id) is the hottest
+#define DIST_ZIPFIAN (1)
+// zipfian with the ranks FNV-hashed over the key space, hot keys are spread out
+#define DIST_SCRAMBLED_ZIPFIAN (2)
+// hot_op_fraction of the ops go to the first hot_set_fraction of the keys
+#define DIST_HOTSPOT (3)
+// YCSB exponential, 95% of the ops on the first 85.7% of the keys
+#define DIST_EXPONENTIAL (4)
+
+#define ZIPFIAN_CONSTANT (0.99)
+// YCSB's scrambled zipfian draws ranks from a fixed 10^10 items, zeta(10^10, 0.99)
+#define SCRAMBLED_ZIPFIAN_ITEMS (10000000000ULL)
+#define SCRAMBLED_ZIPFIAN_ZETAN (26.46902820178302)
+#define EXPONENTIAL_PERCENTILE (95.0)
+#define EXPONENTIAL_FRACTION (0.8571428571)
+// zeta is summed exactly up to this many items, the rest is integrated
+#define ZETA_EXACT_ITEMS (1000000ULL)
+
+// Key ids in [0, num_item). All constants (zeta included) are computed once in
+// the constructor, Next() only reads them and the caller's own random state,
+// so any number of threads can share one distribution without contention.
+class KeyDistribution {
+public:
+    KeyDistribution(int type, uint64_t num_item, double hot_set_fraction = 0.2, double hot_op_fraction = 0.8)
+        : type(type)
+        , num_item(num_item > 0 ? num_item : 1)
+        , theta(ZIPFIAN_CONSTANT)
+        , hot_set_fraction(hot_set_fraction)
+        , hot_op_fraction(hot_op_fraction)
+    {
+        uint64_t zipf_items = (type == DIST_SCRAMBLED_ZIPFIAN) ? SCRAMBLED_ZIPFIAN_ITEMS : this->num_item;
+        zipf_n = zipf_items;
+        zeta2theta = Zeta(2, theta);
+        zetan = (type == DIST_SCRAMBLED_ZIPFIAN) ? SCRAMBLED_ZIPFIAN_ZETAN : Zeta(zipf_items, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1 - pow(2.0 / zipf_items, 1 - theta)) / (1 - zeta2theta / zetan);
+        gamma = -log(1.0 - EXPONENTIAL_PERCENTILE / 100.0) / (this->num_item * EXPONENTIAL_FRACTION);
+        hot_items = (uint64_t)(this->num_item * hot_set_fraction);
+        hot_items = (hot_items == 0) ? 1 : (hot_items > this->num_item ? this->num_item : hot_items);
+    }
+
+    uint64_t Next(uint64_t* state) const
+    {
+        switch (type) {
+        case DIST_ZIPFIAN:
+            return NextZipfian(state);
+        case DIST_SCRAMBLED_ZIPFIAN:
+            return Fnv64(NextZipfian(state)) % num_item;
+        case DIST_HOTSPOT:
+            if (hot_items == num_item || xorshift_double(state) < hot_op_fraction) {
+                return xorshift_random(state) % hot_items;
+            }
+            return hot_items + xorshift_random(state) % (num_item - hot_items);
+        case DIST_EXPONENTIAL:
+            return (uint64_t)(-log(1.0 - xorshift_double(state)) / gamma) % num_item;
+        default:
+            return xorshift_random(state) % num_item;
+        }
+    }
+
+    int Type(void) const
+    {
+        return type;
+    }
+
+    static int Parse(const char* name)
+    {
+        if (strcmp(name, "uniform") == 0) {
+            return DIST_UNIFORM;
+        } else if (strcmp(name, "zipfian") == 0) {
+            return DIST_ZIPFIAN;
+        } else if (strcmp(name, "scrambled") == 0) {
+            return DIST_SCRAMBLED_ZIPFIAN;
+        } else if (strcmp(name, "hotspot") == 0) {
+            return DIST_HOTSPOT;
+        } else if (strcmp(name, "exponential") == 0) {
+            return DIST_EXPONENTIAL;
+        }
+        return -1;
+    }
+
+    static const char* Name(int type)
+    {
+        switch (type) {
+        case DIST_ZIPFIAN:
+            return "zipfian";
+        case DIST_SCRAMBLED_ZIPFIAN:
+            return "scrambled";
+        case DIST_HOTSPOT:
+            return "hotspot";
+        case DIST_EXPONENTIAL:
+            return "exponential";
+        default:
+            return "uniform";
+        }
+    }
+
+    // Seeds a state from any number (0 included) with splitmix64.
+    static uint64_t Seed(uint64_t seed)
+    {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return (z == 0) ? 1 : z;
+    }
+
+private:
+    // "Quickly Generating Billion-Record Synthetic Databases", Gray et al., SIGMOD 1994.
+    uint64_t NextZipfian(uint64_t* state) const
+    {
+        double u = xorshift_double(state);
+        double uz = u * zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + pow(0.5, theta)) {
+            return 1;
+        }
+        uint64_t rank = (uint64_t)(zipf_n * pow(eta * u - eta + 1, alpha));
+        return (rank < zipf_n) ? rank : zipf_n - 1;
+    }
+
+    // sum of 1/i^theta for i in [1, n], the tail past ZETA_EXACT_ITEMS by the
+    // Euler-Maclaurin approximation (relative error far below 1e-9).
+    static double Zeta(uint64_t n, double theta)
+    {
+        uint64_t exact = (n < ZETA_EXACT_ITEMS) ? n : ZETA_EXACT_ITEMS;
+        double sum = 0;
+        for (uint64_t i = 1; i <= exact; i++) {
+            sum += 1 / pow((double)i, theta);
+        }
+        if (n > exact) {
+            double a = (double)exact;
+            double b = (double)n;
+            sum += (pow(b, 1 - theta) - pow(a, 1 - theta)) / (1 - theta);
+            sum += (pow(b, -theta) - pow(a, -theta)) / 2;
+        }
+        return sum;
+    }
+
+    // FNV-1a over the 8 bytes of the rank, as YCSB's fnvhash64.
+    static uint64_t Fnv64(uint64_t value)
+    {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (int i = 0; i < 8; i++) {
+            hash ^= value & 0xff;
+            hash *= 1099511628211ULL;
+            value >>= 8;
+        }
+        return hash;
+    }
+
+private:
+    int type;
+    uint64_t num_item;
+    double theta;
+    double hot_set_fraction;
+    double hot_op_fraction;
+    uint64_t zipf_n;
+    double zetan;
+    double zeta2theta;
+    double alpha;
+    double eta;
+    double gamma;
+    uint64_t hot_items;
+};
+
+#endif
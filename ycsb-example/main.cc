@@ -1,13 +1,62 @@
+#include <assert.h>
 #include <stdio.h>
 
 #include "benchmark.h"
 #include "easylogging/easylogging++.h"
 #include "run_workload.h"
+#include "trace_recorder.h"
+#include "workload_spec.h"
 
 INITIALIZE_EASYLOGGINGPP
 
+#define MAX_WORKLOADS (16)
+
 static int num_workloads = 1;
-static int ycsb_workloads[] = { YCSB_A };
+static int ycsb_workloads[MAX_WORKLOADS] = { YCSB_A };
+
+// Fills ycsb_workloads from a list such as "ycsb_a,ycsb_f_zipf", a "_zipf"
+// suffix draws keys zipfian instead of uniform (YCSB-D always reads the latest).
+static bool parse_workloads(const char* list)
+{
+    static const struct {
+        const char* name;
+        int type;
+    } names[] = { { "ycsb_a", YCSB_A }, { "ycsb_b", YCSB_B }, { "ycsb_c", YCSB_C }, { "ycsb_d", YCSB_D },
+        { "ycsb_e", YCSB_E }, { "ycsb_f", YCSB_F }, { "ycsb_load", YCSB_LOAD } };
+    num_workloads = 0;
+    const char* p = list;
+    while (*p != '\0') {
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+        size_t length = strcspn(p, ", ");
+        if (length == 0) {
+            break;
+        }
+        char token[32];
+        if (length >= sizeof(token) || num_workloads == MAX_WORKLOADS) {
+            return false;
+        }
+        memcpy(token, p, length);
+        token[length] = '\0';
+        p += length;
+
+        int zipfian = 0;
+        if (length > 5 && strcmp(token + length - 5, "_zipf") == 0) {
+            token[length - 5] = '\0';
+            zipfian = YCSB_ZIPFAN;
+        }
+        size_t i = 0;
+        while (i < sizeof(names) / sizeof(names[0]) && strcmp(token, names[i].name) != 0) {
+            i++;
+        }
+        if (i == sizeof(names) / sizeof(names[0])) {
+            return false;
+        }
+        ycsb_workloads[num_workloads++] = names[i].type | zipfian;
+    }
+    return num_workloads > 0;
+}
 
 int main(int argc, char* argv[])
 {
@@ -16,7 +65,7 @@ int main(int argc, char* argv[])
 
     char ssd_path[128] = "./pika_store";
     char pmem_file_path[128] = "/home/pmem0/pm";
-    char benchmark_type[128] = "ycsb_a, ycsb_b, ycsb_c, ycsb_d, ycsb_e, ycsb_f";
+    char benchmark_type[128] = "ycsb_a";
     size_t pmem_file_size = (size_t)512 * 1024 * 1024;
 
     int seq = 0; // seq or random
@@ -27,6 +76,29 @@ int main(int argc, char* argv[])
     int warm_seed[OPT_TYPE_COUNT] = { 1000, 0, 0, 0, 0 };
     int run_seed[OPT_TYPE_COUNT] = { 2000, 1000, 1000, 1000, 1000 };
     uint64_t scan_range = 100;
+    uint64_t target_qps = 0;
+    int arrival = ARRIVAL_CONSTANT;
+    uint64_t report_interval_ms = 0;
+    int report_format = REPORT_CSV;
+    char report_file[128] = "timeline";
+    int placement_policy = PLACEMENT_NONE;
+    char cpu_list[256] = "";
+    char engine_name[128] = "";
+    int queue_depth = 0;
+    int num_executor = 0;
+    int num_client = 0;
+    uint64_t think_time_us = 0;
+    char trace_record[256] = "";
+    char trace_replay[256] = "";
+    int trace_timing = TRACE_TIMING_FAST;
+    int key_distribution = -1; // follow the workload (uniform, or zipfian for "_zipf")
+    double hot_set_fraction = 0.2;
+    double hot_op_fraction = 0.8;
+    WorkloadSpec spec;
+    ValueSize value_size;
+    bool variable_value = false;
+    double compression_ratio = 0;
+    int compression = COMPRESSION_NONE;
 
     for (int i = 0; i < argc; i++) {
         double d;
@@ -52,6 +124,32 @@ int main(int argc, char* argv[])
             num_run_opt[OPT_SCAN] = n;
         } else if (sscanf(argv[i], "--scan_range=%llu%c", &n, &junk) == 1) {
             scan_range = n;
+        } else if (sscanf(argv[i], "--target_qps=%llu%c", &n, &junk) == 1) {
+            target_qps = n;
+        } else if (strncmp(argv[i], "--arrival=", 10) == 0) {
+            arrival = Arrival::Parse(argv[i] + 10);
+            if (arrival < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
+        } else if (sscanf(argv[i], "--report_interval_ms=%llu%c", &n, &junk) == 1) {
+            report_interval_ms = n;
+        } else if (strncmp(argv[i], "--report_format=", 16) == 0) {
+            report_format = Reporter::ParseFormat(argv[i] + 16);
+            if (report_format < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--report_file=", 14) == 0) {
+            strcpy(report_file, argv[i] + 14);
+        } else if (strncmp(argv[i], "--numa_policy=", 14) == 0) {
+            placement_policy = ThreadPlacement::ParsePolicy(argv[i] + 14);
+            if (placement_policy < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--cpu_list=", 11) == 0) {
+            snprintf(cpu_list, sizeof(cpu_list), "%s", argv[i] + 11);
         } else if (sscanf(argv[i], "--seed=%llu%c", &n, &junk) == 1) {
             warm_seed[0] = n;
             run_seed[1] = run_seed[2] = run_seed[3] = run_seed[4] = n;
@@ -61,24 +159,213 @@ int main(int argc, char* argv[])
             strcpy(ssd_path, argv[i] + 5);
         } else if (strncmp(argv[i], "--nvm=", 6) == 0) {
             strcpy(pmem_file_path, argv[i] + 6);
+        } else if (sscanf(argv[i], "--queue_depth=%llu%c", &n, &junk) == 1) {
+            queue_depth = n;
+        } else if (sscanf(argv[i], "--num_executor=%llu%c", &n, &junk) == 1) {
+            num_executor = n;
+        } else if (sscanf(argv[i], "--num_client=%llu%c", &n, &junk) == 1) {
+            num_client = n;
+        } else if (sscanf(argv[i], "--think_time_us=%llu%c", &n, &junk) == 1) {
+            think_time_us = n;
+        } else if (strncmp(argv[i], "--trace_record=", 15) == 0) {
+            snprintf(trace_record, sizeof(trace_record), "%s", argv[i] + 15);
+        } else if (strncmp(argv[i], "--trace_replay=", 15) == 0) {
+            snprintf(trace_replay, sizeof(trace_replay), "%s", argv[i] + 15);
+        } else if (strncmp(argv[i], "--trace_timing=", 15) == 0) {
+            if (strcmp(argv[i] + 15, "fast") == 0) {
+                trace_timing = TRACE_TIMING_FAST;
+            } else if (strcmp(argv[i] + 15, "original") == 0) {
+                trace_timing = TRACE_TIMING_ORIGINAL;
+            } else {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--distribution=", 15) == 0) {
+            key_distribution = KeyDistribution::Parse(argv[i] + 15);
+            if (key_distribution < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
+        } else if (sscanf(argv[i], "--hot_set_fraction=%lf%c", &d, &junk) == 1) {
+            hot_set_fraction = d;
+        } else if (sscanf(argv[i], "--hot_op_fraction=%lf%c", &d, &junk) == 1) {
+            hot_op_fraction = d;
+        } else if (strncmp(argv[i], "--value_size=", 13) == 0) {
+            std::string error;
+            if (!value_size.Parse(argv[i] + 13, &error)) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]: " << error;
+                return 0;
+            }
+            variable_value = true;
+        } else if (sscanf(argv[i], "--compression_ratio=%lf%c", &d, &junk) == 1) {
+            compression_ratio = d;
+            assert(compression_ratio >= 0 && compression_ratio <= 1);
+        } else if (strncmp(argv[i], "--compression=", 14) == 0) {
+            compression = parse_compression(argv[i] + 14);
+            if (compression < 0) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--workload=", 11) == 0) {
+            std::string error;
+            if (!spec.Load(argv[i] + 11, &error)) {
+                LOG(INFO) << "Can not load workload [" << argv[i] + 11 << "]: " << error;
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--engine=", 9) == 0) {
+            strcpy(engine_name, argv[i] + 9);
         } else if (strncmp(argv[i], "--benchmark=", 12) == 0) {
-            strcpy(benchmark_type, argv[i] + 12);
+            snprintf(benchmark_type, sizeof(benchmark_type), "%s", argv[i] + 12);
+            if (!parse_workloads(benchmark_type)) {
+                LOG(INFO) << "Error Parameter [" << argv[i] << "]";
+                return 0;
+            }
         } else if (i > 0) {
             LOG(INFO) << "Error Parameter [" << argv[i] << "]";
             return 0;
         }
     }
 
-    warm_benchmark = new YCSB_Benchmark(YCSB_SEQ_LOAD, num_server_thread, num_warm_opt[0], num_warm_opt[0]);
-    Workload* warm_workload = new Workload(warm_benchmark, nullptr, num_server_thread);
-    warm_workload->Run();
-    warm_benchmark->print();
+    // a cpu list wins over numa_policy wherever either comes on the command line.
+    if (cpu_list[0] != '\0') {
+        placement_policy = PLACEMENT_CPU_LIST;
+    }
+    ThreadPlacement placement;
+    if (!placement.Init(placement_policy, cpu_list)) {
+        LOG(INFO) << "Can not place threads with [" << ThreadPlacement::PolicyName(placement_policy) << "][" << cpu_list << "]";
+        return 0;
+    }
+    // calibrates the clock once, before any worker starts timing.
+    LOG(INFO) << "|- [CLOCK:" << TscClock::Get().Source() << "][TSC:" << TscClock::Get().GHz() << "GHz]";
 
+    // without any engine linked in (ENGINE_SRC) only the workload generator runs.
+    KVEngine* db = nullptr;
+    TraceRecorder* recorder = nullptr;
+    if (engine_name[0] != '\0' || NumKVEngine() == 1) {
+        db = NewKVEngine(engine_name);
+        if (db == nullptr) {
+            LOG(INFO) << "Unknown engine [" << engine_name << "], available engines [" << ListKVEngine() << "]";
+            return 0;
+        }
+        struct engine_options_t engine_options;
+        strcpy(engine_options.db_path, ssd_path);
+        strcpy(engine_options.nvm_path, pmem_file_path);
+        engine_options.num_backend_thread = num_backend_thread;
+        engine_options.pmem_file_size = pmem_file_size;
+        engine_options.compression = compression;
+        if (trace_record[0] != '\0') {
+            recorder = new TraceRecorder(db);
+            if (!recorder->OpenTrace(trace_record)) {
+                LOG(INFO) << "Can not create trace [" << trace_record << "]";
+                delete recorder;
+                return 0;
+            }
+            db = recorder;
+            LOG(INFO) << "|- [TRACE_RECORD:" << trace_record << "]";
+        }
+        bool ok = db->Open(&engine_options);
+        assert(ok);
+        LOG(INFO) << "|- [engine:" << db->Name() << "]";
+    }
+
+    // every value has room for the key id stamped into it.
+    value_size.Clamp(OPT_KEY_LENGTH, OPT_MAX_VALUE_SIZE);
+    const ValueSize* value_sizes = variable_value ? &value_size : nullptr;
+    if (variable_value || compression_ratio > 0) {
+        LOG(INFO) << "|- [VALUE_SIZE:" << (variable_value ? value_size.ToString() : "fixed") << "][COMPRESSION_RATIO:" << compression_ratio << "]";
+    }
+
+    char timeline[256];
+    // a workload spec replaces the warmup and the YCSB workloads, its phases
+    // run back to back on the same open engine.
+    for (size_t p = 0; p < spec.phases.size(); p++) {
+        const phase_spec_t* phase = &spec.phases[p];
+        int num_thread = (phase->num_thread > 0) ? phase->num_thread : num_server_thread;
+        Spec_Benchmark* spec_benchmark = new Spec_Benchmark(phase, (num_client > 0) ? num_client : num_thread, compression_ratio);
+        if (!spec_benchmark->Valid()) {
+            LOG(INFO) << "|- [PHASE:" << phase->name << "] has no op this driver runs, skipped";
+            delete spec_benchmark;
+            continue;
+        }
+        if (phase->mix[SPEC_MULTIGET] > 0) {
+            LOG(INFO) << "|- [PHASE:" << phase->name << "] multiget is not run by this driver";
+        }
+        LOG(INFO) << "|- [PHASE:" << phase->name << "][THREAD:" << num_thread << "][KEYS:" << phase->num_keys << "][OPS:"
+                  << ((phase->duration > 0) ? 0 : phase->NumOps()) << "][DURATION:" << phase->duration << "s][RATE:" << phase->target_qps << "]";
+        Workload* phase_workload = new Workload(spec_benchmark, db, num_thread, phase->target_qps, phase->arrival);
+        snprintf(timeline, sizeof(timeline), "%s_%s.%s", report_file, phase->name.c_str(), Reporter::Extension(report_format));
+        phase_workload->SetTimeline(timeline, report_format, report_interval_ms);
+        phase_workload->SetPlacement(&placement);
+        phase_workload->SetQueueDepth(queue_depth, num_executor);
+        phase_workload->SetClients(num_client, think_time_us * 1000);
+        phase_workload->SetScanRange(phase->scan_range);
+        phase_workload->Run();
+        spec_benchmark->print();
+        delete phase_workload;
+        delete spec_benchmark;
+    }
+    if (!spec.phases.empty()) {
+        num_warm_opt[0] = 0;
+        num_workloads = 0;
+    }
+
+    if (num_warm_opt[0] > 0) {
+        YCSB_Benchmark* load_benchmark = new YCSB_Benchmark(YCSB_SEQ_LOAD, num_server_thread, num_warm_opt[0], num_warm_opt[0]);
+        load_benchmark->SetValueSize(value_sizes, compression_ratio);
+        warm_benchmark = load_benchmark;
+        Workload* warm_workload = new Workload(warm_benchmark, db, num_server_thread);
+        snprintf(timeline, sizeof(timeline), "%s_warm.%s", report_file, Reporter::Extension(report_format));
+        warm_workload->SetTimeline(timeline, report_format, report_interval_ms);
+        warm_workload->SetPlacement(&placement);
+        warm_workload->Run();
+        warm_benchmark->print();
+    }
+
+    // every coroutine client draws from its own generator.
+    int num_generator = (num_client > 0) ? num_client : num_server_thread;
+    // a replayed trace replaces the YCSB workloads of the run phase.
+    if (trace_replay[0] != '\0') {
+        TraceReplay_Benchmark* replay = new TraceReplay_Benchmark(trace_replay, num_generator, trace_timing);
+        if (!replay->Valid()) {
+            LOG(INFO) << "Can not replay trace [" << trace_replay << "]";
+            return 0;
+        }
+        LOG(INFO) << "|- [TRACE_REPLAY:" << trace_replay << "][RECORDS:" << replay->Header()->num_record << "]";
+        Workload* run_workload = new Workload(replay, db, num_server_thread, target_qps, arrival);
+        snprintf(timeline, sizeof(timeline), "%s_replay.%s", report_file, Reporter::Extension(report_format));
+        run_workload->SetTimeline(timeline, report_format, report_interval_ms);
+        run_workload->SetPlacement(&placement);
+        run_workload->SetQueueDepth(queue_depth, num_executor);
+        run_workload->SetClients(num_client, think_time_us * 1000);
+        run_workload->SetScanRange(scan_range);
+        run_workload->Run();
+        replay->print();
+        num_workloads = 0;
+    }
     for (int i = 0; i < num_workloads; i++) {
-        run_benchmark = new YCSB_Benchmark(ycsb_workloads[i], num_server_thread, num_warm_opt[0], num_run_opt[0]);
-        Workload* run_workload = new Workload(run_benchmark, nullptr, num_server_thread);
+        YCSB_Benchmark* ycsb_benchmark = new YCSB_Benchmark(ycsb_workloads[i], num_generator, num_warm_opt[0], num_run_opt[0]);
+        if (key_distribution >= 0) {
+            ycsb_benchmark->SetKeyDistribution(key_distribution, hot_set_fraction, hot_op_fraction);
+        }
+        ycsb_benchmark->SetValueSize(value_sizes, compression_ratio);
+        run_benchmark = ycsb_benchmark;
+        Workload* run_workload = new Workload(run_benchmark, db, num_server_thread, target_qps, arrival);
+        snprintf(timeline, sizeof(timeline), "%s_run_%d.%s", report_file, i, Reporter::Extension(report_format));
+        run_workload->SetTimeline(timeline, report_format, report_interval_ms);
+        run_workload->SetPlacement(&placement);
+        run_workload->SetQueueDepth(queue_depth, num_executor);
+        run_workload->SetClients(num_client, think_time_us * 1000);
+        run_workload->SetScanRange(scan_range);
         run_workload->Run();
         run_benchmark->print();
     }
+    if (db != nullptr) {
+        // keys that do not fit a trace record are left out of it, a replay does not send them.
+        if (recorder != nullptr && recorder->NumRejected() > 0) {
+            LOG(INFO) << "|- [TRACE_RECORD] " << recorder->NumRejected() << " requests with keys over " << TRACE_MAX_KEY_LENGTH << "B were left out!";
+        }
+        db->Close();
+        delete db;
+    }
     return 0;
 }
@@ -1,4 +1,8 @@
 #include "benchmark.h"
+#include "client_scheduler.h"
+#include "executor_pool.h"
+#include "histogram.h"
+#include "latency_file.h"
 #include "timer.h"
 
 #include "easylogging/easylogging++.h"
@@ -6,183 +10,580 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <condition_variable>
+#include <mutex>
+#include <new>
 #include <pthread.h>
+#include <string>
 #include <vector>
 
-#define SCAN_RANGE 100
+#define SCAN_RANGE (100)
 
-static int numa_0[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
-    20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
-    10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
-    30, 31, 32, 33, 34, 35, 36, 37, 38, 39 };
-
-struct thread_param_t {
+// Each thread writes only its own (cache-line aligned) entry.
+struct alignas(CACHE_LINE_SIZE) thread_param_t {
 public:
-    void* db;
+    KVEngine* db;
     int thread_id;
     Benchmark* benchmark;
+    const ThreadPlacement* placement;
+    Histogram* histogram; // [OPT_TYPE_COUNT], allocated by the thread, freed by Workload::Run
+    double target_qps;
+    int arrival;
     uint64_t total_time;
     uint64_t sum_opt_count;
     uint64_t sum_count[OPT_TYPE_COUNT];
     uint64_t sum_latency[OPT_TYPE_COUNT];
+    uint64_t sum_response[OPT_TYPE_COUNT]; // latency since the intended send time
     uint64_t sum_success_count[OPT_TYPE_COUNT];
     uint64_t get_succeed;
     uint64_t put_succeed;
     uint64_t scan_succeed;
     uint64_t update_succeed;
+    uint64_t delete_succeed;
+    uint64_t rmw_succeed;
     size_t bytes;
+    uint64_t start_ns; // when the thread left the start barrier
+    uint64_t end_ns; // when the thread issued its last op
+    pthread_barrier_t* barrier; // all threads and Workload::Run start together
+    thread_param_t** local; // where the thread publishes the entry it works on
+    ExecutorPool* pool; // nullptr runs every op on the thread itself
+    int queue_depth; // requests kept in flight through the pool
+    int num_thread;
+    int num_client; // coroutine clients of all threads, 0 runs the thread as one client
+    uint64_t think_time_ns;
+    size_t scan_range;
 };
 
 // #define STORE_EACH_LATENCY
 #if (defined STORE_EACH_LATENCY)
-static std::vector<uint64_t> vec_opt_latency[32][OPT_TYPE_COUNT];
+static std::vector<std::vector<uint64_t> > vec_opt_latency; // [thread * OPT_TYPE_COUNT + type]
 #endif
 
-static void result_output(const char* name, std::vector<uint64_t>& data)
+#if (defined STORE_EACH_LATENCY)
+static void result_output(const char* name, int thread_id, const char* op_name, const std::vector<uint64_t>& data)
 {
-    std::ofstream fout(name);
-    if (fout.is_open()) {
-        for (int i = 0; i < data.size(); i++) {
-            fout << data[i] << std::endl;
-        }
-        fout.close();
+    if (write_latency_file(name, thread_id, op_name, data)) {
         LOG(INFO) << "|- Detailed results have been output to the file : " << name;
     }
 }
+#endif
 
-static void* thread_task(void* thread_args)
+// Runs one op against db (nothing without an engine), true if it succeeded.
+static bool execute_op(KVEngine* db, int type, const uint8_t* key, size_t key_length, const uint8_t* value, size_t value_length,
+    size_t scan_range, std::string* get_value, std::vector<std::string>* scan_values)
 {
-    thread_param_t* param = (struct thread_param_t*)thread_args;
-    int thread_id = param->thread_id;
+    if (db == nullptr) {
+        return false;
+    }
+    switch (type) {
+    case OPT_PUT:
+    case OPT_UPDATE:
+        return db->Put((const char*)key, key_length, (const char*)value, value_length);
+    case OPT_GET:
+        return db->Get((const char*)key, key_length, get_value);
+    case OPT_DELETE:
+        return db->Delete((const char*)key, key_length);
+    case OPT_SCAN:
+        return db->Scan((const char*)key, key_length, scan_range, scan_values) > 0;
+    case OPT_RMW:
+        // the modified record is written whether or not the read found it.
+        db->Get((const char*)key, key_length, get_value);
+        return db->Put((const char*)key, key_length, (const char*)value, value_length);
+    default:
+        return false;
+    }
+}
+
+// latency is the engine call, response also counts the wait since the intended
+// send time (and, pipelined, the time queued behind other requests).
+static void record_op(thread_param_t* param, int type, uint64_t latency, uint64_t response, bool success)
+{
+    param->sum_latency[type] += latency;
+    param->sum_response[type] += response;
+    param->histogram[type].Add(response);
+#if (defined STORE_EACH_LATENCY)
+    vec_opt_latency[param->thread_id * OPT_TYPE_COUNT + type].push_back(response);
+#endif
+    param->sum_count[type]++;
+    param->sum_opt_count++;
+    if (!success) {
+        return;
+    }
+    if (type == OPT_PUT) {
+        param->put_succeed++;
+    } else if (type == OPT_UPDATE) {
+        param->update_succeed++;
+    } else if (type == OPT_GET) {
+        param->get_succeed++;
+    } else if (type == OPT_DELETE) {
+        param->delete_succeed++;
+    } else if (type == OPT_SCAN) {
+        param->scan_succeed++;
+    } else if (type == OPT_RMW) {
+        param->rmw_succeed++;
+    }
+}
 
+// Requests of one pipelined thread that executors have finished.
+struct completion_queue_t {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<int> done; // slots
+};
+
+// One in-flight request. The benchmark reuses its key/value buffers on every
+// get_kv_item(), so each slot keeps its own copy.
+struct async_request_t {
+    KVEngine* db;
+    size_t scan_range;
+    completion_queue_t* completion;
+    int slot;
+    int type;
+    std::string key;
+    std::string value;
+    uint64_t send_delay;
+    uint64_t submit_ns;
+    uint64_t complete_ns;
+    uint64_t service_ns;
+    bool success;
+    std::string get_value;
+    std::vector<std::string> scan_values;
+};
+
+// Runs on an executor thread.
+static void execute_request(void* arg)
+{
+    async_request_t* request = (async_request_t*)arg;
+    Timer timer;
+    request->scan_values.clear();
+    timer.Start();
+    request->success = execute_op(request->db, request->type, (const uint8_t*)request->key.data(), request->key.size(),
+        (const uint8_t*)request->value.data(), request->value.size(), request->scan_range, &request->get_value, &request->scan_values);
+    timer.Stop();
+    request->service_ns = timer.Get();
+    request->complete_ns = Arrival::Now();
+
+    // the request belongs to its thread again once it is on the queue.
+    completion_queue_t* completion = request->completion;
+    std::lock_guard<std::mutex> lock(completion->mutex);
+    completion->done.push_back(request->slot);
+    completion->cond.notify_one();
+}
+
+// Keeps queue_depth requests of the thread in flight on the executor pool and
+// records every request when it completes.
+static void run_pipelined(thread_param_t* param, Arrival* arrival)
+{
+    int thread_id = param->thread_id;
+    int queue_depth = param->queue_depth;
     Benchmark* benchmark = param->benchmark;
-    assert(benchmark != nullptr);
-    benchmark->init_thread();
+    ExecutorPool* pool = param->pool;
 
-#if (defined THREAD_BIND_CPU)
-    cpu_set_t mask;
-    CPU_ZERO(&mask);
-    CPU_SET(numa_0[thread_id], &mask);
-    if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) < 0) {
-        printf("threadpool, set thread affinity failed.\n");
+    completion_queue_t completion;
+    std::vector<async_request_t> requests(queue_depth);
+    std::vector<int> free_slots;
+    std::vector<int> done;
+    for (int i = 0; i < queue_depth; i++) {
+        requests[i].db = param->db;
+        requests[i].scan_range = param->scan_range;
+        requests[i].completion = &completion;
+        requests[i].slot = i;
+        free_slots.push_back(queue_depth - 1 - i);
     }
-#endif
+    // consecutive requests go to consecutive executors, threads start apart.
+    int next_executor = thread_id * queue_depth;
+    int num_inflight = 0;
+    bool exhausted = false;
 
-    int result;
     uint8_t* key;
     uint8_t* value;
     size_t key_length;
     size_t value_length;
-    uint64_t scan_count;
+    while (true) {
+        while (!exhausted && !free_slots.empty()) {
+            int test_type = benchmark->get_kv_item(thread_id, &key, key_length, &value, value_length);
+            if (test_type == -1) {
+                exhausted = true;
+                break;
+            }
+            async_request_t* request = &requests[free_slots.back()];
+            free_slots.pop_back();
+            request->type = test_type;
+            request->key.assign((const char*)key, key_length);
+            request->value.assign((const char*)value, value_length);
+            param->bytes += value_length;
 
-    Timer little_timer, total_timer;
-    uint64_t latency = 0;
-    total_timer.Start();
+            request->send_delay = arrival->Wait();
+            request->submit_ns = Arrival::Now();
+            pool->Submit(next_executor++, execute_request, request);
+            num_inflight++;
+        }
+        if (num_inflight == 0) {
+            break;
+        }
+        {
+            std::unique_lock<std::mutex> lock(completion.mutex);
+            completion.cond.wait(lock, [&completion]() {
+                return !completion.done.empty();
+            });
+            done.swap(completion.done);
+        }
+        for (size_t i = 0; i < done.size(); i++) {
+            async_request_t* request = &requests[done[i]];
+            uint64_t response = request->complete_ns - request->submit_ns + request->send_delay;
+            record_op(param, request->type, request->service_ns, response, request->success);
+            free_slots.push_back(request->slot);
+            num_inflight--;
+        }
+        done.clear();
+    }
+}
 
+// One simulated client: it gives up the thread while it thinks or until its next
+// open-loop request is due. get_value/scan_values are shared by all clients of
+// the thread, an op never suspends halfway.
+static ClientTask client_task(ClientScheduler* scheduler, thread_param_t* param, int client_id, double target_qps,
+    std::string* get_value, std::vector<std::string>* scan_values)
+{
+    Benchmark* benchmark = param->benchmark;
+    Arrival arrival(param->arrival, target_qps, (uint64_t)(client_id + 1) * 987654321);
+    arrival.Start();
+
+    uint8_t* key;
+    uint8_t* value;
+    size_t key_length;
+    size_t value_length;
+    Timer timer;
+    // the request is ready to go at ready_ns, response time includes the wait
+    // for the other clients of the thread.
+    uint64_t ready_ns = Arrival::Now();
     while (true) {
-        int test_type = benchmark->get_kv_item(thread_id, &key, key_length, &value, value_length);
-        param->bytes += value_length;
+        if (arrival.OpenLoop()) {
+            ready_ns = arrival.Next();
+        }
+        co_await scheduler->SleepUntil(ready_ns);
+        int test_type = benchmark->get_kv_item(client_id, &key, key_length, &value, value_length);
         if (test_type == -1) {
             break;
         }
-#if (defined STORE_EACH_LATENCY)
-        little_timer.Start();
-#endif
-        if (test_type == OPT_PUT) {
-        } else if (test_type == OPT_UPDATE) {
-        } else if (test_type == OPT_GET) {
-        } else if (test_type == OPT_DELETE) {
-        } else if (test_type == OPT_SCAN) {
+        param->bytes += value_length;
+        scan_values->clear();
+        timer.Start();
+        bool success = execute_op(param->db, test_type, key, key_length, value, value_length, param->scan_range, get_value, scan_values);
+        timer.Stop();
+        uint64_t end_ns = Arrival::Now();
+        record_op(param, test_type, timer.Get(), end_ns - std::min(ready_ns, end_ns), success);
+        ready_ns = end_ns + param->think_time_ns;
+    }
+}
+
+// Runs the clients thread_id, thread_id + num_thread, ... on this thread.
+static void run_clients(thread_param_t* param)
+{
+    int num_thread = param->num_thread;
+    std::string get_value;
+    std::vector<std::string> scan_values;
+    ClientScheduler scheduler;
+    int num_local = 0;
+    for (int c = param->thread_id; c < param->num_client; c += num_thread) {
+        num_local++;
+    }
+    for (int c = param->thread_id; c < param->num_client; c += num_thread) {
+        scheduler.Spawn(client_task(&scheduler, param, c, param->target_qps / num_local, &get_value, &scan_values));
+    }
+    scheduler.Run();
+}
+
+static void* thread_task(void* thread_args)
+{
+    thread_param_t* setup = (struct thread_param_t*)thread_args;
+    int thread_id = setup->thread_id;
+
+    // bind first, everything the thread allocates below (its own copy of the
+    // entry included) is then local to its node. Workload::Run wrote setup.
+    if (setup->placement != nullptr) {
+        setup->placement->Bind(thread_id);
+    }
+    thread_param_t* param = setup;
+    void* local;
+    if (posix_memalign(&local, CACHE_LINE_SIZE, sizeof(thread_param_t)) == 0) {
+        param = new (local) thread_param_t(*setup);
+    }
+    *setup->local = param;
+
+    Benchmark* benchmark = param->benchmark;
+    KVEngine* db = param->db;
+    assert(benchmark != nullptr);
+    param->histogram = new Histogram[OPT_TYPE_COUNT];
+    // with clients, the benchmark has a generator per client instead of per thread.
+    if (param->num_client > 0) {
+        for (int c = thread_id; c < param->num_client; c += param->num_thread) {
+            benchmark->init_thread(c);
         }
+    } else {
+        benchmark->init_thread(thread_id);
+    }
 
-#if (defined STORE_EACH_LATENCY)
-        little_timer.Stop();
-        latency = little_timer.Get();
-        param->sum_latency[test_type] += latency;
-        vec_opt_latency[thread_id][test_type].push_back(latency);
-#endif
-        param->sum_count[test_type]++;
-        param->sum_opt_count++;
+    uint8_t* key;
+    uint8_t* value;
+    size_t key_length;
+    size_t value_length;
+    std::string get_value;
+    std::vector<std::string> scan_values;
+
+    Timer little_timer, total_timer;
+    uint64_t latency = 0;
+    uint64_t send_delay = 0;
+    Arrival arrival(param->arrival, param->target_qps, (uint64_t)(thread_id + 1) * 987654321);
+    pthread_barrier_wait(param->barrier);
+    param->start_ns = Arrival::Now();
+    total_timer.Start();
+    arrival.Start();
+
+    if (param->num_client > 0) {
+        run_clients(param);
+    } else if (param->pool != nullptr) {
+        run_pipelined(param, &arrival);
+    } else {
+        while (true) {
+            int test_type = benchmark->get_kv_item(thread_id, &key, key_length, &value, value_length);
+            if (test_type == -1) {
+                break;
+            }
+            param->bytes += value_length;
+            send_delay = arrival.Wait();
+            scan_values.clear();
+            little_timer.Start();
+            bool success = execute_op(db, test_type, key, key_length, value, value_length, param->scan_range, &get_value, &scan_values);
+            little_timer.Stop();
+            latency = little_timer.Get();
+            record_op(param, test_type, latency, latency + send_delay, success);
+        }
     }
     total_timer.Stop();
     param->total_time = total_timer.Get();
+    param->end_ns = Arrival::Now();
     return NULL;
 }
 
-Workload::Workload(Benchmark* benchmark, void* db, int num_thread)
+Workload::Workload(Benchmark* benchmark, KVEngine* db, int num_thread, uint64_t target_qps, int arrival)
     : benchmark(benchmark)
     , db(db)
     , num_thread(num_thread)
+    , target_qps(target_qps)
+    , arrival(target_qps > 0 ? arrival : ARRIVAL_CLOSED)
+    , report_format(REPORT_CSV)
+    , report_interval_ms(0)
+    , placement(nullptr)
+    , queue_depth(0)
+    , num_executor(0)
+    , num_client(0)
+    , think_time_ns(0)
+    , scan_range(SCAN_RANGE)
+{
+    report_file[0] = '\0';
+}
+
+void Workload::SetTimeline(const char* path, int format, uint64_t interval_ms)
+{
+    snprintf(report_file, sizeof(report_file), "%s", path);
+    report_format = format;
+    report_interval_ms = interval_ms;
+}
+
+void Workload::SetPlacement(const ThreadPlacement* placement)
+{
+    this->placement = placement;
+}
+
+void Workload::SetQueueDepth(int queue_depth, int num_executor)
 {
+    this->queue_depth = queue_depth;
+    this->num_executor = num_executor;
 }
 
+void Workload::SetClients(int num_client, uint64_t think_time_ns)
+{
+    this->num_client = num_client;
+    this->think_time_ns = think_time_ns;
+}
+
+void Workload::SetScanRange(size_t scan_range)
+{
+    this->scan_range = scan_range;
+}
+
+static const char* opt_type_name[OPT_TYPE_COUNT] = { "PUT", "UPDATE", "GET", "DELETE", "SCAN", "RMW" };
+
 void Workload::Run()
 {
-    pthread_t thread_id[32];
-    thread_param_t thread_params[32];
+    std::vector<pthread_t> thread_id(num_thread);
+    // every thread copies its setup entry into one it allocates once it is
+    // bound, and publishes that in thread_params (nullptr until it started).
+    thread_param_t* thread_setup;
+    if (posix_memalign((void**)&thread_setup, CACHE_LINE_SIZE, num_thread * sizeof(thread_param_t)) != 0) {
+        LOG(INFO) << "|- Can not allocate " << num_thread << " threads.";
+        return;
+    }
+    std::vector<thread_param_t*> thread_params(num_thread, nullptr);
+    // filled in from thread_params once every thread has allocated its histograms.
+    std::vector<Histogram*> histograms(num_thread, nullptr);
+    ExecutorPool* pool = nullptr;
+    if (num_client > 0) {
+        LOG(INFO) << "|- [CLIENTS:" << num_client << "][THREAD:" << num_thread << "][THINK:" << think_time_ns / 1000 << "us]";
+    } else if (queue_depth > 0) {
+        pool = new ExecutorPool(num_executor, placement, num_thread);
+        LOG(INFO) << "|- [PIPELINE][QUEUE_DEPTH:" << queue_depth << "][EXECUTOR:" << pool->NumExecutor() << "][INFLIGHT:" << queue_depth * num_thread << "]";
+    }
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_thread + 1);
+
+    for (int i = 0; i < num_thread; i++) {
+        memset(&thread_setup[i], 0, sizeof(thread_param_t));
+        thread_setup[i].thread_id = i;
+        thread_setup[i].benchmark = benchmark;
+        thread_setup[i].placement = placement;
+        thread_setup[i].target_qps = 1.0 * target_qps / num_thread;
+        thread_setup[i].arrival = arrival;
+        thread_setup[i].db = db;
+        thread_setup[i].bytes = 0;
+        thread_setup[i].barrier = &barrier;
+        thread_setup[i].local = &thread_params[i];
+        thread_setup[i].pool = pool;
+        thread_setup[i].queue_depth = queue_depth;
+        thread_setup[i].num_thread = num_thread;
+        thread_setup[i].num_client = num_client;
+        thread_setup[i].think_time_ns = think_time_ns;
+        thread_setup[i].scan_range = scan_range;
+    }
 
+#if (defined STORE_EACH_LATENCY)
+    vec_opt_latency.resize(num_thread * OPT_TYPE_COUNT);
+#endif
+    Reporter reporter(report_file, report_format, report_interval_ms, histograms.data(), num_thread, OPT_TYPE_COUNT, opt_type_name);
+
+    for (int i = 0; i < num_thread; i++) {
+        pthread_create(&thread_id[i], NULL, thread_task, (void*)&thread_setup[i]);
+    }
+    // the run is timed on the wall clock from the moment every thread is ready.
+    pthread_barrier_wait(&barrier);
+    uint64_t start_ns = Arrival::Now();
     for (int i = 0; i < num_thread; i++) {
-        memset(&thread_params[i], 0, sizeof(thread_param_t));
-        thread_params[i].thread_id = i;
-        thread_params[i].benchmark = benchmark;
-        thread_params[i].db = db;
-        thread_params[i].bytes = 0;
-        pthread_create(thread_id + i, NULL, thread_task, (void*)&thread_params[i]);
+        histograms[i] = thread_params[i]->histogram;
+    }
+    if (reporter.Start()) {
+        LOG(INFO) << "|- [TIMELINE:" << report_file << "][INTERVAL:" << report_interval_ms << "ms]";
     }
 
     for (int i = 0; i < num_thread; i++) {
         pthread_join(thread_id[i], NULL);
     }
+    reporter.Stop();
+    pthread_barrier_destroy(&barrier);
+    delete pool;
 
-    uint64_t total_iops = 0;
-    uint64_t avg_latency = 0;
+    // a thread may run (or even finish) before this thread reads the clock
+    // after the barrier, so the run starts with the earliest thread.
+    uint64_t end_ns = start_ns;
+    for (int i = 0; i < num_thread; i++) {
+        start_ns = std::min(start_ns, thread_params[i]->start_ns);
+    }
+    uint64_t total_opt = 0;
+    size_t total_bytes = 0;
+    uint64_t total_latency = 0;
     uint64_t get_succeed = 0;
     uint64_t put_succeed = 0;
     uint64_t scan_succeed = 0;
     uint64_t update_succeed = 0;
-    size_t sum_bw = 0;
+    uint64_t delete_succeed = 0;
+    uint64_t rmw_succeed = 0;
 
     for (int i = 0; i < num_thread; i++) {
         uint64_t sum_opt = 0;
         uint64_t sum_latency_ns = 0;
         uint64_t avg_latency_ns;
         for (int j = 0; j < OPT_TYPE_COUNT; j++) {
-            sum_opt += thread_params[i].sum_count[j];
-            sum_latency_ns += thread_params[i].sum_latency[j];
+            sum_opt += thread_params[i]->sum_count[j];
+            sum_latency_ns += thread_params[i]->sum_latency[j];
         }
         // double sum_latency_s = 1.0 * sum_latency_ns / (1000 * 1000 * 1000);
         // avg_latency_ns = sum_latency_ns / sum_opt;
         // uint64_t iops_1 = 1000000000.0 / avg_latency_ns;
         // LOG(INFO) << "|- [Each][Count:" << sum_opt << "][Time:" << sum_latency_s << "seconds][IOPS:" << iops_1 << "][Latency:" << avg_latency_ns << "ns]";
-        double total_time = 1.0 * thread_params[i].total_time / (1000 * 1000 * 1000);
-        avg_latency_ns = 1.0 * thread_params[i].total_time / sum_opt;
+        if (sum_opt == 0) {
+            continue;
+        }
+        double total_time = 1.0 * thread_params[i]->total_time / (1000 * 1000 * 1000);
+        avg_latency_ns = 1.0 * thread_params[i]->total_time / sum_opt;
         uint64_t iops_2 = 1000000000.0 / avg_latency_ns;
-        double bw = thread_params[i].bytes / (1024 * 1024 * total_time);
-        sum_bw += bw;
         LOG(INFO) << "|- [Total][Count:" << sum_opt << "][Time:" << total_time << "seconds][IOPS:" << iops_2 << "][Latency:" << avg_latency_ns << "ns]";
-        total_iops += iops_2;
-        avg_latency += avg_latency_ns;
-        put_succeed += thread_params[i].put_succeed;
-        update_succeed += thread_params[i].update_succeed;
-        get_succeed += thread_params[i].get_succeed;
-        scan_succeed += thread_params[i].scan_succeed;
+        end_ns = std::max(end_ns, thread_params[i]->end_ns);
+        total_opt += sum_opt;
+        total_latency += sum_latency_ns;
+        total_bytes += thread_params[i]->bytes;
+        put_succeed += thread_params[i]->put_succeed;
+        update_succeed += thread_params[i]->update_succeed;
+        get_succeed += thread_params[i]->get_succeed;
+        scan_succeed += thread_params[i]->scan_succeed;
+        delete_succeed += thread_params[i]->delete_succeed;
+        rmw_succeed += thread_params[i]->rmw_succeed;
     }
 
-    LOG(INFO) << "|- [IOPS:" << total_iops << "][Latency:" << avg_latency / num_thread << "ns]";
-    LOG(INFO) << "|- [BW:" << sum_bw << "MB/s]";
+    // aggregate rates divide by the run's wall time, not each thread's own busy time.
+    double wall_time = (end_ns - start_ns) / 1000000000.0;
+    uint64_t total_iops = (wall_time > 0) ? total_opt / wall_time : 0;
+    double total_bw = (wall_time > 0) ? total_bytes / (1024.0 * 1024 * wall_time) : 0;
+    uint64_t avg_latency = (total_opt == 0) ? 0 : total_latency / total_opt;
+
+    LOG(INFO) << "|- [Count:" << total_opt << "][Wall:" << wall_time << "seconds][IOPS:" << total_iops << "][Latency:" << avg_latency << "ns]";
+    LOG(INFO) << "|- [BW:" << total_bw << "MB/s]";
+    for (int j = 0; j < OPT_TYPE_COUNT; j++) {
+        Histogram merged;
+        for (int i = 0; i < num_thread; i++) {
+            merged.Merge(thread_params[i]->histogram[j]);
+        }
+        if (merged.Count() > 0) {
+            LOG(INFO) << "|- [" << opt_type_name[j] << "]" << merged.ToString();
+        }
+    }
+    for (int i = 0; i < num_thread; i++) {
+        delete[] thread_params[i]->histogram;
+    }
+    if (target_qps > 0) {
+        LOG(INFO) << "|- [OPEN-LOOP][TARGET:" << target_qps << "ops/s][ARRIVAL:" << Arrival::Name(arrival) << "]";
+        for (int j = 0; j < OPT_TYPE_COUNT; j++) {
+            uint64_t count = 0;
+            uint64_t service_time = 0;
+            uint64_t response_time = 0;
+            for (int i = 0; i < num_thread; i++) {
+                count += thread_params[i]->sum_count[j];
+                service_time += thread_params[i]->sum_latency[j];
+                response_time += thread_params[i]->sum_response[j];
+            }
+            if (count > 0) {
+                LOG(INFO) << "|- [" << opt_type_name[j] << "][Count:" << count << "][Service:" << service_time / count << "ns][Response:" << response_time / count << "ns]";
+            }
+        }
+    }
 #if (defined STORE_EACH_LATENCY)
     mkdir("detail_latency", 0777);
     for (int i = 0; i < num_thread; i++) {
         for (int j = 0; j < OPT_TYPE_COUNT; j++) {
-            if (vec_opt_latency[i][j].size() > 0) {
+            if (vec_opt_latency[i * OPT_TYPE_COUNT + j].size() > 0) {
                 char name[128];
-                snprintf(name, sizeof(name), "detail_latency/%d_%d.lightkv", i, j);
-                result_output(name, vec_opt_latency[i][j]);
-                vec_opt_latency[i][j].clear();
+                snprintf(name, sizeof(name), "detail_latency/%d_%d." LATENCY_EXTENSION, i, j);
+                result_output(name, i, opt_type_name[j], vec_opt_latency[i * OPT_TYPE_COUNT + j]);
+                vec_opt_latency[i * OPT_TYPE_COUNT + j].clear();
             }
         }
     }
 #endif
-    LOG(INFO) << "|- [OK_PUT:" << put_succeed << "][OK_UPDATE:" << update_succeed << "][OK_GET:" << get_succeed << "]";
+    for (int i = 0; i < num_thread; i++) {
+        if (thread_params[i] != &thread_setup[i]) {
+            free(thread_params[i]);
+        }
+    }
+    free(thread_setup);
+    LOG(INFO) << "|- [OK_PUT:" << put_succeed << "][OK_UPDATE:" << update_succeed << "][OK_GET:" << get_succeed << "][OK_DELETE:" << delete_succeed << "][OK_SCAN:" << scan_succeed << "][OK_RMW:" << rmw_succeed << "]";
     LOG(INFO) << "|-------------------------------------------";
 }
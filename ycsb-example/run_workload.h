@@ -6,22 +6,52 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arrival.h"
 #include "benchmark.h"
+#include "kv_engine.h"
+#include "reporter.h"
+#include "thread_placement.h"
 
-#define MAX_TEST_THREAD (32)
 #define TEST_KEY_LENGTH (16)
 #define TEST_VALUE_LENGTH (128)
 
 class Workload {
 public:
-    Workload(Benchmark* benchmark, void* db, int num_thread);
+    // db may be nullptr, the run then only measures the workload generator.
+    Workload(Benchmark* benchmark, KVEngine* db, int num_thread, uint64_t target_qps = 0, int arrival = ARRIVAL_CLOSED);
     void Run();
     void Print();
+    // Samples a throughput/latency timeline into path every interval_ms during Run().
+    void SetTimeline(const char* path, int format, uint64_t interval_ms);
+    // Binds worker threads to CPUs, nullptr (default) leaves them unbound.
+    void SetPlacement(const ThreadPlacement* placement);
+    // queue_depth > 0 makes every thread keep that many requests in flight on a
+    // pool of num_executor executor threads (0, one per CPU) running the
+    // blocking engine calls. 0 (default) runs one request at a time per thread.
+    void SetQueueDepth(int queue_depth, int num_executor);
+    // num_client > 0 runs that many client coroutines multiplexed over the
+    // threads instead of one client per thread (the benchmark then needs
+    // num_client generators). A client waits think_time_ns between its ops.
+    // Takes precedence over SetQueueDepth.
+    void SetClients(int num_client, uint64_t think_time_ns);
+    // Records each scan visits (100 default).
+    void SetScanRange(size_t scan_range);
 
 private:
-    void* db;
+    KVEngine* db;
     int num_thread;
     Benchmark* benchmark;
+    uint64_t target_qps; // 0 is closed-loop
+    int arrival;
+    char report_file[256];
+    int report_format;
+    uint64_t report_interval_ms; // 0 disables the timeline
+    const ThreadPlacement* placement;
+    int queue_depth;
+    int num_executor;
+    int num_client;
+    uint64_t think_time_ns;
+    size_t scan_range;
 };
 
 #endif
\ No newline at end of file
@@ -79,6 +79,7 @@ public:
     {
         printf("[LightKVServer::LightKVServer] LightKVServer Start!\n");
         search_match = 0;
+        delete_match = 0;
         output = 0;
         option.num_server_thread = 1;
         option.num_backend_thread = 4;
@@ -143,7 +144,7 @@ public:
             }
 
             size_t sum_opt = vec_lat_insert.size() + vec_lat_update.size() + vec_lat_search.size() + vec_lat_delete.size() + vec_lat_scan.size();
-            printf("[LightKVServer::addMap] [SUM:%zu][PUT:%zu][UPDATE:%zu][GET:%llu/%zu][DEL:%zu][SCAN:%zu]\n", sum_opt, vec_lat_insert.size(), vec_lat_update.size(), search_match, vec_lat_search.size(), vec_lat_delete.size(), vec_lat_scan.size());
+            printf("[LightKVServer::addMap] [SUM:%zu][PUT:%zu][UPDATE:%zu][GET:%llu/%zu][DEL:%llu/%zu][SCAN:%zu]\n", sum_opt, vec_lat_insert.size(), vec_lat_update.size(), search_match, vec_lat_search.size(), delete_match, vec_lat_delete.size(), vec_lat_scan.size());
 
 #if (defined LATENCY_OUTPUT)
             if (vec_lat_insert.size() > 0) {
@@ -178,6 +179,7 @@ public:
             result_output("DELETE", vec_lat_delete);
             result_output("SCAN", vec_lat_scan);
             search_match = 0;
+            delete_match = 0;
             output++;
             vec_lat_insert.clear();
             vec_lat_search.clear();
@@ -385,6 +387,41 @@ public:
 
     ResponseCode::type remove(const std::string& mapName, const std::string& string_key)
     {
+        if ((string_key.size() - 4) > YCSB_KEY_LENGTH) {
+            std::cout << string_key << std::endl;
+            printf("[LightKVServer::Remove] Invaild key length: %zu\n", string_key.size());
+        }
+        assert((string_key.size() - 4) <= YCSB_KEY_LENGTH);
+
+        boost::ptr_map<std::string, LightKV>::iterator itr;
+        boost::shared_lock<boost::shared_mutex> readLock(mutex_);
+        itr = maps_.find(mapName);
+
+        if (itr == maps_.end()) {
+            printf("[LightKVServer::Remove] Invaild Mapper!\n");
+            return ResponseCode::MapNotFound;
+        }
+
+        Timer timer;
+        uint64_t latency_ns;
+        uint8_t key[YCSB_KEY_LENGTH] = { 0 };
+        size_t key_length = YCSB_KEY_LENGTH;
+
+        for (int i = 0; i < key_length; i++) {
+            key[i] = '0';
+        }
+        memcpy(key, string_key.data() + 4, string_key.size() - 4); // remove 'user' head
+
+        timer.Start();
+        bool res = itr->second->Delete(key, key_length);
+        timer.Stop();
+        latency_ns = timer.Get();
+        vec_lat_delete.push_back(latency_ns);
+
+        if (!res) {
+            return ResponseCode::RecordNotFound;
+        }
+        delete_match++;
         return ResponseCode::Success;
     }
 
@@ -395,6 +432,7 @@ private:
 
 private:
     uint64_t search_match;
+    uint64_t delete_match;
     std::vector<uint64_t> vec_lat_insert;
     std::vector<uint64_t> vec_lat_update;
     std::vector<uint64_t> vec_lat_search;